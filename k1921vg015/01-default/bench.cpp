@@ -0,0 +1,128 @@
+#include <K1921VG015.h>
+#include <system_k1921vg015.h>
+#include <cstdio>
+extern "C" {
+#include <retarget.h>
+#include <riscv-csr.h>
+#include <irq_stats.h>
+#include <perf.h>
+}
+#include "format.h"
+#include "bench.h"
+
+/**
+ * @brief   Вывод опросом, как в прежнем retarget_put_char(): ожидание BUSY перед каждым байтом.
+ *
+ */
+static void UartWritePolled( const char *Data, int Size )
+{
+    for ( int i = 0; i < Size; i++ )
+    {
+        while ( RETARGET_UART->FR & UART_FR_BUSY_Msk )
+        {
+        }
+        RETARGET_UART->DR = Data[i];
+    }
+}
+
+/**
+ * @brief   Время CPU на вывод 1 КБ в UART: опросом и через буфер передачи retarget.
+ *
+ *          С буфером время CPU - это время внутри retarget_write() (retarget_stats.write_cycles)
+ *          и время прерываний UART (irq_stats), ожидание передачи в него не входит:
+ *          данные пишутся порциями по 256 байт, между порциями retarget_flush().
+ *
+ */
+void RetargetBenchmark()
+{
+    static char Line[64];
+    const int Lines = 16;
+
+    for ( int i = 0; i < ( int ) sizeof( Line ) - 1; i++ )
+    {
+        Line[i] = ( char ) ( 'A' + i % 26 );
+    }
+    Line[sizeof( Line ) - 1] = '\n';
+
+    retarget_flush();
+
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+    for ( int i = 0; i < Lines; i++ )
+    {
+        UartWritePolled( Line, sizeof( Line ) );
+    }
+    uint32_t Polled = ( uint32_t ) csr_read_mcycle() - Start;
+
+    volatile irq_stats_entry_t *Irq = &irq_stats.irq[IRQ_STATS_PLIC( IsrVect_IRQ_UART0 )];
+
+    retarget_flush();
+    retarget_stats_reset();
+    irq_stats_reset();
+
+    for ( int i = 0; i < Lines; i++ )
+    {
+        retarget_write( Line, sizeof( Line ) );
+        if ( i % 4 == 3 )
+        {
+            retarget_flush();
+        }
+    }
+
+    uint32_t Write = ( uint32_t ) retarget_stats.write_cycles;
+    uint32_t Count = Irq->count;
+    uint32_t Isr = ( uint32_t ) ( Irq->sum_dispatch + Irq->sum_duration );
+
+    printf( "UART %u baud, SYSCLK %u Hz, CPU cycles per KB: polled %u, buffered %u (write %u, %u interrupts %u).\n",
+            ( unsigned int ) RETARGET_UART_BAUD, ( unsigned int ) SystemCoreClock, ( unsigned int ) Polled,
+            ( unsigned int ) ( Write + Isr ), ( unsigned int ) Write, ( unsigned int ) Count, ( unsigned int ) Isr );
+}
+
+/**
+ * @brief   Такты на строку: snprintf() из printf.cpp (разбор формата при выполнении) и
+ *          fmt::format_to() (формат разобран при компиляции).
+ *
+ */
+void FormatBenchmark()
+{
+    const uint32_t Count = 100;
+    char Buf[64];
+
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        snprintf( Buf, sizeof( Buf ), "id %5u val %8d hex 0x%08X\n", ( unsigned int ) i, -( int ) i * 1000,
+                  ( unsigned int ) Start );
+    }
+    uint32_t Runtime = ( uint32_t ) csr_read_mcycle() - Start;
+
+    Start = ( uint32_t ) csr_read_mcycle();
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        fmt::format_to( Buf, FMT( "id %5u val %8d hex 0x%08X\n" ), i, -( int ) i * 1000, Start );
+    }
+    uint32_t Compiled = ( uint32_t ) csr_read_mcycle() - Start;
+
+    printf( "snprintf %u cycles, format_to %u cycles per line.\n", ( unsigned int ) ( Runtime / Count ),
+            ( unsigned int ) ( Compiled / Count ) );
+}
+
+/**
+ * @brief   Вывод в UART на каждом уровне производительности.
+ *
+ *          UART0 тактируется от PLL0, поэтому без уведомления retarget (RETARGET_PERF)
+ *          строки на уровнях LOW и MID выводились бы с неверной скоростью.
+ *
+ */
+void PerfUartTest()
+{
+    static const perf_level_t Levels[] = { PERF_LEVEL_LOW, PERF_LEVEL_MID, PERF_LEVEL_HIGH };
+    static const char *const Names[] = { "low", "mid", "high" };
+
+    for ( perf_level_t Level : Levels )
+    {
+        int Result = perf_set_level( Level );
+
+        printf( "perf %s: %s, SYSCLK %u Hz, UART0 %u baud.\n", Names[Level], Result == 0 ? "ok" : "failed",
+                ( unsigned int ) SystemCoreClock, ( unsigned int ) RETARGET_UART_BAUD );
+    }
+}
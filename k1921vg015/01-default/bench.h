@@ -0,0 +1,24 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// Замеры вывода в UART, собираются с опцией RETARGET (см. CMakeLists.txt).
+
+/**
+ * @brief   Время CPU на вывод 1 КБ в UART: опросом и через буфер передачи retarget.
+ *
+ */
+void RetargetBenchmark();
+
+/**
+ * @brief   Время форматирования строки: snprintf() из printf.cpp и fmt::format_to().
+ *
+ */
+void FormatBenchmark();
+
+/**
+ * @brief   Вывод в UART на каждом уровне производительности.
+ *
+ */
+void PerfUartTest();
+
+#endif // _BENCH_H_
@@ -4,6 +4,14 @@ extern "C" {
 #include <mtimer.h>
 }
 #include "version.h"
+#ifdef RETARGET
+#include "bench.h"
+
+extern "C" {
+#include <perf.h>
+#include <retarget.h>
+}
+#endif
 
 /**
  * @brief   Точка входа в программу.
@@ -17,9 +25,23 @@ int main( void )
     // Настройка тактирования.
     SystemCoreClockUpdate();
 
+#ifdef RETARGET
+    // Уровни производительности от частоты PLL, выбранной при старте.
+    perf_init();
+
+    // UART0 для printf().
+    retarget_init();
+#endif
+
     // Включаем глобальные прерывания.
     InterruptEnable();
 
+#ifdef RETARGET
+    RetargetBenchmark();
+    FormatBenchmark();
+    PerfUartTest();
+#endif
+
     // Разрешаем тактирование GPIOC.
     RCU->CGCFGAHB_bit.GPIOCEN = 1;
 
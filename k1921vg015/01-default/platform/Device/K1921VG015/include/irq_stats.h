@@ -0,0 +1,121 @@
+#ifndef IRQ_STATS_H
+#define IRQ_STATS_H
+
+#include <stdint.h>
+
+#include "riscv-irq.h"
+
+/** Per-interrupt latency and duration statistics.
+ *
+ * Enabled with IRQ_STATS, otherwise all hooks expand to nothing. The table is
+ * the global irq_stats, it can be read from the debugger or dumped over RTT.
+ * All values are mcycle cycles:
+ * - latency is the time from the claim to the handler call. For a PLIC source
+ *   the claim is the return of PLIC_ClaimIrq(); a core-local interrupt has no
+ *   claim register, it is claimed by reading mcause at the trap entry;
+ * - dispatch is the time from trap_handler()/irq_entry() to the handler call,
+ *   i.e. cause decoding, the PLIC claim and the latency above;
+ * - duration is the time spent in the handler itself, nested interrupts
+ *   (PLIC_NESTED_IRQ) are not counted. The MTHR/MIE setup of the nested mode
+ *   runs after the handler call is stamped and is part of it.
+ */
+
+/** Table index of a PLIC source and of a core-local interrupt (mcause code).
+ */
+#define IRQ_STATS_PLIC(ISR_NUM)  (ISR_NUM)
+#define IRQ_STATS_CORE(IRQ_NUM)  (32 + (IRQ_NUM))
+#define IRQ_STATS_NUM            (32 + RISCV_IRQ_NUMS)
+
+#ifdef IRQ_STATS
+
+#include "riscv-csr.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_latency;
+    uint32_t max_dispatch;
+    uint32_t last_duration;
+    uint32_t max_duration;
+    uint64_t sum_latency;
+    uint64_t sum_dispatch;
+    uint64_t sum_duration;
+} irq_stats_entry_t;
+
+typedef struct {
+    uint32_t depth;          // Current nesting depth
+    uint32_t max_depth;
+    uint32_t trap_cycle;     // mcycle at the entry of the current trap
+    uint32_t nested_cycles;  // Cycles taken by nested interrupts of the current level
+    irq_stats_entry_t irq[IRQ_STATS_NUM];
+} irq_stats_t;
+
+extern volatile irq_stats_t irq_stats;
+
+/** Reset the statistics table.
+ */
+void irq_stats_reset(void);
+
+/** Handler call bookkeeping, kept on the stack of the interrupted level.
+ */
+typedef struct {
+    uint32_t trap;
+    uint32_t claim;
+    uint32_t start;
+    uint32_t nested;
+} irq_stats_frame_t;
+
+static inline void irq_stats_trap(void) {
+    irq_stats.trap_cycle = (uint32_t)csr_read_mcycle();
+}
+
+static inline void irq_stats_begin(irq_stats_frame_t *frame, uint32_t claim) {
+    frame->trap = irq_stats.trap_cycle;
+    frame->claim = claim;
+    frame->nested = irq_stats.nested_cycles;
+    irq_stats.nested_cycles = 0;
+    if (++irq_stats.depth > irq_stats.max_depth) irq_stats.max_depth = irq_stats.depth;
+    frame->start = (uint32_t)csr_read_mcycle();
+}
+
+static inline void irq_stats_end(irq_stats_frame_t *frame, uint32_t index) {
+    uint32_t end = (uint32_t)csr_read_mcycle();
+    uint32_t latency = frame->start - frame->claim;
+    uint32_t dispatch = frame->start - frame->trap;
+    uint32_t duration = end - frame->start - irq_stats.nested_cycles;
+    volatile irq_stats_entry_t *entry = &irq_stats.irq[index];
+
+    entry->count++;
+    entry->last_duration = duration;
+    entry->sum_latency += latency;
+    entry->sum_dispatch += dispatch;
+    entry->sum_duration += duration;
+    if (latency > entry->max_latency) entry->max_latency = latency;
+    if (dispatch > entry->max_dispatch) entry->max_dispatch = dispatch;
+    if (duration > entry->max_duration) entry->max_duration = duration;
+
+    // The whole trap counts as nested time for the interrupted level
+    irq_stats.nested_cycles = frame->nested + (end - frame->trap);
+    irq_stats.depth--;
+}
+
+/* IRQ_STATS_BEGIN() is for core-local interrupts (claimed at the trap entry),
+ * a PLIC handler stamps the claim with IRQ_STATS_CLAIM() right after
+ * PLIC_ClaimIrq() and passes it to IRQ_STATS_BEGIN_CLAIMED().
+ */
+#define IRQ_STATS_TRAP()                        irq_stats_trap()
+#define IRQ_STATS_CLAIM(CLAIM)                  uint32_t CLAIM = (uint32_t)csr_read_mcycle()
+#define IRQ_STATS_BEGIN(FRAME)                  irq_stats_frame_t FRAME; irq_stats_begin(&FRAME, irq_stats.trap_cycle)
+#define IRQ_STATS_BEGIN_CLAIMED(FRAME, CLAIM)   irq_stats_frame_t FRAME; irq_stats_begin(&FRAME, CLAIM)
+#define IRQ_STATS_END(FRAME, INDEX)             irq_stats_end(&FRAME, INDEX)
+
+#else // IRQ_STATS
+
+#define IRQ_STATS_TRAP()
+#define IRQ_STATS_CLAIM(CLAIM)
+#define IRQ_STATS_BEGIN(FRAME)
+#define IRQ_STATS_BEGIN_CLAIMED(FRAME, CLAIM)
+#define IRQ_STATS_END(FRAME, INDEX)
+
+#endif // IRQ_STATS
+
+#endif // IRQ_STATS_H
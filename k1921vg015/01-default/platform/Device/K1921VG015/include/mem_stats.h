@@ -0,0 +1,69 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdint.h>
+
+/** Stack and heap usage monitoring.
+ *
+ * plf_init_generic() paints the free RAM between the end of .bss and the
+ * current stack pointer (the heap area and the unused stack) with
+ * MEM_STATS_PAINT. mem_stats_scan() then looks for the lowest stack word that
+ * is no longer painted; the stack only grows down, so a scan pass starts at
+ * the bottom of the stack and stops at the previous high-water mark. A pass
+ * is split over several calls of at most MEM_STATS_SCAN_WORDS loads each, so
+ * a call from the idle loop stays short however much stack is still unused.
+ * The pass goes upwards on purpose: a stack frame may leave painted holes
+ * (e.g. an unused local buffer), scanning down from the mark would stop there.
+ *
+ * _sbrk() (the newlib heap) is implemented here: the break never passes
+ * _heap_end, i.e. the bottom of the stack reserve (or HEAP_FIXED_AFTER_BSS),
+ * refused requests fail with ENOMEM and are counted.
+ *
+ * All results are in the global mem_stats, it can be read from the debugger
+ * or dumped over RTT.
+ */
+
+#ifndef MEM_STATS_PAINT
+#define MEM_STATS_PAINT 0xA5A5A5A5u
+#endif
+
+/** Stack words checked by one mem_stats_scan() call at most.
+ */
+#ifndef MEM_STATS_SCAN_WORDS
+#define MEM_STATS_SCAN_WORDS 64
+#endif
+
+typedef struct {
+    uint32_t stack_size;      // Bytes reserved for the stack (STACK_SIZE)
+    uint32_t stack_peak;      // Deepest stack use found by mem_stats_scan()
+    uint32_t stack_overflow;  // Set once the bottom word of the stack reserve was overwritten
+    uint32_t heap_size;       // Bytes between _heap_start and _heap_end
+    uint32_t heap_used;       // Current break above _heap_start
+    uint32_t heap_peak;
+    uint32_t heap_failed;     // _sbrk() requests refused
+    uint32_t scans;           // Number of mem_stats_scan() calls, not passes
+    uint32_t last_scan_cycles;
+} mem_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile mem_stats_t mem_stats;
+
+/** Paint the free RAM below the stack pointer and reset the statistics.
+ * Called once from plf_init_generic() after .bss is cleared.
+ */
+void mem_stats_paint(void);
+
+/** Continue the scan pass for the stack high-water mark, cheap enough for the
+ * idle loop. Returns nonzero when the pass is finished, i.e. stack_peak is up
+ * to date: while (!mem_stats_scan()) {} before reading it once.
+ */
+int mem_stats_scan(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_STATS_H
@@ -0,0 +1,114 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+#include "clk_config.h"
+
+/** Run-time performance levels.
+ *
+ * The PLL levels are profiles solved at compile time from clk_config.h
+ * (PLL_PROFILE(), the C form of pll_solve()), OUT[1] stays at SYSCLK_PLL1_HZ
+ * in all of them:
+ * - PERF_LEVEL_HIGH runs from PLL OUT[0] at SYSCLK_PLL_HZ, the boot profile
+ *   PLL_SYS_* of ClkInit() (SYSCLK_PLL);
+ * - PERF_LEVEL_MID runs from PLL OUT[0] at PERF_MID_HZ;
+ * - PERF_LEVEL_LOW runs from HSE, the PLL keeps running for a fast return.
+ * A profile that cannot be reached exactly (see SYSCLK_PLL_TOLERANCE_HZ)
+ * stops the build.
+ *
+ * perf_set_level() switches with interrupts masked: SYSCLK moves to HSE, all
+ * PLL dividers of the profile are programmed (the PLL is relocked only if
+ * REFDIV, FBDIV or FRAC change, the wait is bounded by PERF_LOCK_TIMEOUT_US of
+ * mtime), flash wait states are raised before the clock goes up,
+ * SystemCoreClockUpdate() then recomputes SystemCoreClock and lowers the flash
+ * latency, and the mtime rate used by the tick conversions is updated
+ * (MTIMER_DYNAMIC_FREQ, see mtimer.h).
+ *
+ * Drivers whose clocks depend on SYSCLK or PLL OUT[0] register a notifier.
+ * Notifiers are called with interrupts masked, PERF_PRE_CHANGE while the old
+ * clock still runs and PERF_POST_CHANGE after all globals are updated, so they
+ * must only wait for or reprogram their hardware.
+ *
+ * The only notifier in this tree is the one of the retarget UART
+ * (platform/retarget, built with RETARGET_PERF as in the RETARGET option of
+ * 01-default), it re-tunes the baud rate when RETARGET_UART_CLKSEL selects a
+ * PLL output. The RTT sample has no UART. Any other peripheral clocked from
+ * SYSCLK or the PLL, e.g. another UART, SPI or a timer, keeps its old dividers
+ * after a switch unless its driver registers a notifier.
+ */
+
+/** SYSCLK of PERF_LEVEL_MID.
+ */
+#ifndef PERF_MID_HZ
+#define PERF_MID_HZ (SYSCLK_PLL_HZ / 2)
+#endif
+
+/** Longest wait for the PLL lock, in us. mtime counts HSE during the wait.
+ */
+#ifndef PERF_LOCK_TIMEOUT_US
+#define PERF_LOCK_TIMEOUT_US 1000
+#endif
+
+typedef enum {
+    PERF_LEVEL_LOW,
+    PERF_LEVEL_MID,
+    PERF_LEVEL_HIGH,
+    PERF_LEVEL_NUM
+} perf_level_t;
+
+typedef enum {
+    PERF_PRE_CHANGE,
+    PERF_POST_CHANGE
+} perf_event_t;
+
+typedef struct perf_notifier perf_notifier_t;
+
+/** Notifier callback, hz is the new SYSCLK frequency for both events.
+ */
+typedef void perf_notifier_func_t(perf_notifier_t *notifier, perf_event_t event, uint32_t hz);
+
+struct perf_notifier {
+    perf_notifier_t *next;
+    perf_notifier_func_t *func;
+    void *arg;
+};
+
+typedef struct {
+    uint32_t switches;
+    uint32_t failed;       // PLL did not lock or the clock did not switch
+    uint32_t last_cycles;  // mcycle of the last switch, counted at the old, HSE and new clocks
+    uint32_t last_ns;
+    uint32_t max_ns;
+} perf_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile perf_stats_t perf_stats;
+
+/** Record the boot PLL configuration, call after SystemInit().
+ */
+void perf_init(void);
+
+/** Switch to a performance level.
+ * @return 0 on success, -1 if the level is not available or the switch failed
+ * (the system then stays at or returns to HSE)
+ */
+int perf_set_level(perf_level_t level);
+
+perf_level_t perf_get_level(void);
+
+/** SYSCLK frequency of a level.
+ */
+uint32_t perf_level_hz(perf_level_t level);
+
+void perf_notifier_register(perf_notifier_t *notifier, perf_notifier_func_t *func, void *arg);
+void perf_notifier_unregister(perf_notifier_t *notifier);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERF_H
@@ -0,0 +1,124 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/** Binary event trace with mtime timestamps.
+ *
+ * An event is 2..16 bytes: a head byte (event id, bit 7 set if a payload
+ * follows), the mtime delta to the previous stored event as an unsigned
+ * LEB128 varint and the optional LEB128 payload. Events are handed to an
+ * output function that stores the whole event or nothing (rtt_trace_start()
+ * installs an RTT up-channel, a lock-free ring drained by the debug probe).
+ * A lost event does not advance the time base, so the deltas stay exact; the
+ * number of lost events is reported by an OVERFLOW event in front of the next
+ * stored one. mtime counts SYSCLK, so perf_set_level() records every clock
+ * change with a FREQ event: the delta of an event elapsed at the frequency of
+ * the previous START or FREQ event.
+ *
+ * Producers are serialized by masking MIE for the few instructions of one
+ * event, so the hooks may be used from any context.
+ *
+ * The built-in hooks (interrupt entry/exit, swtimer callbacks, sleep() and
+ * wfi) are compiled in with TRACE, otherwise they expand to nothing. Markers
+ * and spans can always be emitted explicitly. tools/rtt_trace.py converts a
+ * captured stream to Chrome trace JSON.
+ */
+
+#define TRACE_PAYLOAD 0x80
+
+enum {
+    TRACE_EV_START = 0,       // payload: mtime frequency in Hz
+    TRACE_EV_OVERFLOW,        // payload: number of lost events
+    TRACE_EV_IRQ_ENTER,       // payload: IRQ_STATS_PLIC()/IRQ_STATS_CORE() index
+    TRACE_EV_IRQ_EXIT,        // payload: same index
+    TRACE_EV_TIMER_ENTER,     // payload: swtimer callback address
+    TRACE_EV_TIMER_EXIT,
+    TRACE_EV_SLEEP_BEGIN,     // payload: requested delay in mtime clocks (saturated)
+    TRACE_EV_SLEEP_END,
+    TRACE_EV_WFI_ENTER,
+    TRACE_EV_WFI_EXIT,
+    TRACE_EV_MARK,            // payload: user value
+    TRACE_EV_SPAN_BEGIN,      // payload: user span id
+    TRACE_EV_SPAN_END,        // payload: user span id
+    TRACE_EV_FREQ,            // payload: new mtime frequency in Hz, see trace_freq()
+    TRACE_EV_USER = 32,       // First application-defined id, up to 127
+};
+
+/** Output function, stores all size bytes or nothing.
+ * @return Non-zero if the event was stored.
+ */
+typedef unsigned trace_output_t(const void *data, unsigned size);
+
+typedef struct {
+    uint32_t events;         // Events stored
+    uint32_t lost;           // Events lost because the output was full
+} trace_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile trace_stats_t trace_stats;
+
+/** Start tracing to output and emit the START event.
+ */
+void trace_start(trace_output_t *output);
+
+/** Stop tracing, the following events are discarded.
+ */
+void trace_stop(void);
+
+/** Record one event.
+ * @param head Event id, or'ed with TRACE_PAYLOAD if payload is to be stored.
+ */
+void trace_emit(uint32_t head, uint32_t payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline void trace_mark(uint32_t value) {
+    trace_emit(TRACE_EV_MARK | TRACE_PAYLOAD, value);
+}
+
+static inline void trace_span_begin(uint32_t id) {
+    trace_emit(TRACE_EV_SPAN_BEGIN | TRACE_PAYLOAD, id);
+}
+
+static inline void trace_span_end(uint32_t id) {
+    trace_emit(TRACE_EV_SPAN_END | TRACE_PAYLOAD, id);
+}
+
+/** Record that mtime counts at hz from now on, e.g. after a clock switch.
+ */
+static inline void trace_freq(uint32_t hz) {
+    trace_emit(TRACE_EV_FREQ | TRACE_PAYLOAD, hz);
+}
+
+#ifdef TRACE
+
+#define TRACE_IRQ_ENTER(INDEX)          trace_emit(TRACE_EV_IRQ_ENTER | TRACE_PAYLOAD, INDEX)
+#define TRACE_IRQ_EXIT(INDEX)           trace_emit(TRACE_EV_IRQ_EXIT | TRACE_PAYLOAD, INDEX)
+#define TRACE_TIMER_ENTER(FUNC)         trace_emit(TRACE_EV_TIMER_ENTER | TRACE_PAYLOAD, (uint32_t)(FUNC))
+#define TRACE_TIMER_EXIT()              trace_emit(TRACE_EV_TIMER_EXIT, 0)
+#define TRACE_SLEEP_BEGIN(CLOCKS)       trace_emit(TRACE_EV_SLEEP_BEGIN | TRACE_PAYLOAD, \
+                                                   (CLOCKS) > UINT32_MAX ? UINT32_MAX : (uint32_t)(CLOCKS))
+#define TRACE_SLEEP_END()               trace_emit(TRACE_EV_SLEEP_END, 0)
+#define TRACE_WFI_ENTER()               trace_emit(TRACE_EV_WFI_ENTER, 0)
+#define TRACE_WFI_EXIT()                trace_emit(TRACE_EV_WFI_EXIT, 0)
+
+#else // TRACE
+
+#define TRACE_IRQ_ENTER(INDEX)
+#define TRACE_IRQ_EXIT(INDEX)
+#define TRACE_TIMER_ENTER(FUNC)
+#define TRACE_TIMER_EXIT()
+#define TRACE_SLEEP_BEGIN(CLOCKS)
+#define TRACE_SLEEP_END()
+#define TRACE_WFI_ENTER()
+#define TRACE_WFI_EXIT()
+
+#endif // TRACE
+
+#endif // TRACE_H
@@ -0,0 +1,24 @@
+#include "irq_stats.h"
+
+#ifdef IRQ_STATS
+volatile irq_stats_t irq_stats;
+
+void irq_stats_reset(void)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    for (uint32_t i = 0; i < IRQ_STATS_NUM; i++) {
+        irq_stats.irq[i].count = 0;
+        irq_stats.irq[i].max_latency = 0;
+        irq_stats.irq[i].max_dispatch = 0;
+        irq_stats.irq[i].last_duration = 0;
+        irq_stats.irq[i].max_duration = 0;
+        irq_stats.irq[i].sum_latency = 0;
+        irq_stats.irq[i].sum_dispatch = 0;
+        irq_stats.irq[i].sum_duration = 0;
+    }
+    irq_stats.max_depth = irq_stats.depth;
+
+    csr_write_mstatus(mstatus);
+}
+#endif // IRQ_STATS
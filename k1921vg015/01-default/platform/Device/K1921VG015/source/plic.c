@@ -8,6 +8,10 @@
 
 #include "csr.h"
 #include "plic.h"
+#include "riscv-irq.h"
+#include "riscv-csr.h"
+#include "irq_stats.h"
+#include "trace.h"
 
 // pointers to handler functions for machine mode
 irqfunc* mach_plic_handler[32] __attribute__((section(".data")));
@@ -166,12 +170,31 @@ void PLIC_MachHandler(void) {
 
 	// handle interrupt
 	uint32_t isr_num = PLIC_ClaimIrq(Plic_Mach_Target);
+	IRQ_STATS_CLAIM(claimed);
 	// check if handler exist
 	if(mach_plic_handler[isr_num] != NULL_IRQ) {
+		IRQ_STATS_BEGIN_CLAIMED(stats, claimed);
+		TRACE_IRQ_ENTER(IRQ_STATS_PLIC(isr_num));
+#ifdef PLIC_NESTED_IRQ
+		// only sources with a higher priority may preempt this handler
+		uint32_t threshold = PLIC->MTHR;
+		PLIC->MTHR = PLIC->PRI[isr_num];
+		// trap_entry keeps mepc/mstatus on the stack, so MIE can be re-enabled
+		csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
 		// call isr handler
 		mach_plic_handler[isr_num]();
+		csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
 		// set isr completes
 		PLIC_ClaimComplete(Plic_Mach_Target, isr_num);
+		PLIC->MTHR = threshold;
+#else
+		// call isr handler
+		mach_plic_handler[isr_num]();
+		// set isr completes
+		PLIC_ClaimComplete(Plic_Mach_Target, isr_num);
+#endif // PLIC_NESTED_IRQ
+		TRACE_IRQ_EXIT(IRQ_STATS_PLIC(isr_num));
+		IRQ_STATS_END(stats, IRQ_STATS_PLIC(isr_num));
 	}
 }
 
@@ -190,6 +213,8 @@ void PLIC_MachHandler(void) {
 
 void trap_handler (void)
 {
+	IRQ_STATS_TRAP();
+
 	uint32_t mcause_val = read_csr(mcause);
 	uint32_t mepc = read_csr(0x341);   // mepc
 
@@ -224,8 +249,17 @@ void trap_handler (void)
 
 		//while(1) {}; //TRAP
 	} else {
-		// handle interrupt
-		PLIC_MachHandler();
+		// handle interrupt: core-local ones (e.g. machine timer) via riscv_handler_map
+		uint32_t irq_num = mcause_val & MCAUSE_EXCEPT_MASK;
+		if(irq_num != RISCV_IRQ_MEI && irq_num < RISCV_IRQ_NUMS && riscv_handler_map[irq_num] != NULL_IRQ) {
+			IRQ_STATS_BEGIN(stats);
+			TRACE_IRQ_ENTER(IRQ_STATS_CORE(irq_num));
+			riscv_handler_map[irq_num]();
+			TRACE_IRQ_EXIT(IRQ_STATS_CORE(irq_num));
+			IRQ_STATS_END(stats, IRQ_STATS_CORE(irq_num));
+		} else {
+			PLIC_MachHandler();
+		}
 	}
 }
 
@@ -18,16 +18,147 @@
  *==============================================================================
  */
 
+#include <unistd.h>
+
 #include "retarget.h"
-#define SystemCoreClock_uart	HSECLK_VAL
+#include "plic.h"
+#include "riscv-csr.h"
+#include "system_k1921vg015.h"
+#ifdef RETARGET_PERF
+#include "perf.h"
+#endif
 #define USE_LIBC
+
+#define RETARGET_TX_MASK (RETARGET_TX_BUFFER_SIZE - 1)
+#define RETARGET_RX_MASK (RETARGET_RX_BUFFER_SIZE - 1)
+
+_Static_assert((RETARGET_TX_BUFFER_SIZE & RETARGET_TX_MASK) == 0, "RETARGET_TX_BUFFER_SIZE must be a power of two");
+_Static_assert((RETARGET_RX_BUFFER_SIZE & RETARGET_RX_MASK) == 0, "RETARGET_RX_BUFFER_SIZE must be a power of two");
+
+//-- Variables -----------------------------------------------------------------
+/** Кольцевые буферы. Индексы свободно бегущие, заполнение равно head - tail.
+ * В буфер передачи пишет retarget_write(), читает прерывание UART; в буфер
+ * приема наоборот.
+ */
+static struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint8_t data[RETARGET_TX_BUFFER_SIZE];
+} retarget_tx;
+
+static struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint8_t data[RETARGET_RX_BUFFER_SIZE];
+} retarget_rx;
+
+volatile retarget_stats_t retarget_stats;
+
 //-- Functions -----------------------------------------------------------------
+/** Дозаполнить FIFO передатчика из буфера и включить прерывание TX, пока в
+ * буфере остаются данные. Вызывается с запрещенными прерываниями.
+ */
+static void retarget_tx_fill(void)
+{
+    uint32_t tail = retarget_tx.tail;
+    uint32_t head = retarget_tx.head;
+
+    while (tail != head && !(RETARGET_UART->FR & UART_FR_TXFF_Msk)) {
+        RETARGET_UART->DR = retarget_tx.data[tail & RETARGET_TX_MASK];
+        tail++;
+    }
+    retarget_tx.tail = tail;
+
+    if (tail == head)
+        RETARGET_UART->IMSC &= ~UART_IMSC_TXIM_Msk;
+    else
+        RETARGET_UART->IMSC |= UART_IMSC_TXIM_Msk;
+}
+
+/** Переложить принятые байты из FIFO приемника в буфер.
+ * Вызывается с запрещенными прерываниями.
+ */
+static void retarget_rx_drain(void)
+{
+    while (!(RETARGET_UART->FR & UART_FR_RXFE_Msk)) {
+        uint8_t data = RETARGET_UART->DR_bit.DATA;
+        uint32_t head = retarget_rx.head;
+
+        if (head - retarget_rx.tail < RETARGET_RX_BUFFER_SIZE) {
+            retarget_rx.data[head & RETARGET_RX_MASK] = data;
+            retarget_rx.head = head + 1;
+            retarget_stats.rx_bytes++;
+        } else {
+            retarget_stats.rx_dropped++;
+        }
+    }
+}
+
+/** При PLIC_NESTED_IRQ обработчик идет с разрешенными прерываниями: буферы
+ * обслуживаются с запретом, чтобы не пересечься с опросом из вложенного
+ * обработчика.
+ */
+static void retarget_uart_irq(void)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    uint32_t mis = RETARGET_UART->MIS;
+
+    // Прерывания по уровню FIFO снова выставятся, если уровень не изменится
+    RETARGET_UART->ICR = mis & (UART_ICR_RXIC_Msk | UART_ICR_RTIC_Msk | UART_ICR_TXIC_Msk);
+
+    if (mis & (UART_IMSC_RXIM_Msk | UART_IMSC_RTIM_Msk))
+        retarget_rx_drain();
+    if (mis & UART_IMSC_TXIM_Msk)
+        retarget_tx_fill();
+    csr_write_mstatus(mstatus);
+}
+
+/** Частота тактирования UART по текущим настройкам RCU.
+ */
+static uint32_t retarget_uart_clock(void)
+{
+    switch (RETARGET_UART_CLKSEL) {
+        case RCU_UARTCLKCFG_CLKSEL_HSI:  return HSICLK_VAL;
+        case RCU_UARTCLKCFG_CLKSEL_PLL0: return SystemPll0Clock;
+        case RCU_UARTCLKCFG_CLKSEL_PLL1: return SystemPll1Clock;
+        default:                         return HSECLK_VAL;
+    }
+}
+
+/** Делители скорости: clk / (16 * baud) в формате 16.6, с округлением.
+ * Новые IBRD/FBRD защелкиваются записью LCRH.
+ */
+static void retarget_set_baud(void)
+{
+    uint32_t div = (retarget_uart_clock() * 4 + RETARGET_UART_BAUD / 2) / RETARGET_UART_BAUD;
+
+    RETARGET_UART->IBRD = div >> 6;
+    RETARGET_UART->FBRD = div & 0x3F;
+    RETARGET_UART->LCRH = RETARGET_UART->LCRH;
+}
+
+#ifdef RETARGET_PERF
+static perf_notifier_t retarget_perf;
+
+/** Смена частоты: дождаться конца передачи текущего символа, затем пересчитать делители.
+ */
+static void retarget_perf_notify(perf_notifier_t *notifier, perf_event_t event, uint32_t hz)
+{
+    (void)notifier;
+    (void)hz;
+
+    if (event == PERF_PRE_CHANGE) {
+        while (RETARGET_UART->FR & UART_FR_BUSY_Msk) {
+        }
+    } else {
+        retarget_set_baud();
+    }
+}
+#endif // RETARGET_PERF
+
 void retarget_init()
 {
 #if defined RETARGET
-    uint32_t baud_icoef = SystemCoreClock_uart / (16 * RETARGET_UART_BAUD);
-    uint32_t baud_fcoef = ((SystemCoreClock_uart / (16.0f * RETARGET_UART_BAUD) - baud_icoef) * 64 + 0.5f);
-    uint32_t uartclk_ref = 1;//RCU_UARTCFG_UARTCFG_CLKSEL_OSICLK;
 
     RCU->CGCFGAHB_bit.GPIOAEN = 1;
     RCU->RSTDISAHB_bit.GPIOAEN = 1;
@@ -37,54 +168,162 @@ void retarget_init()
     RETARGET_UART_PORT->ALTFUNCNUM_bit.PIN0 = 1;
     RETARGET_UART_PORT->ALTFUNCNUM_bit.PIN1 = 1;
     RETARGET_UART_PORT->ALTFUNCSET = (1 << RETARGET_UART_PIN_TX_POS) | (1 << RETARGET_UART_PIN_RX_POS);
-    RCU->UARTCLKCFG[RETARGET_UART_NUM].UARTCLKCFG = (uartclk_ref << RCU_UARTCLKCFG_CLKSEL_Pos) |
+    RCU->UARTCLKCFG[RETARGET_UART_NUM].UARTCLKCFG = (RETARGET_UART_CLKSEL << RCU_UARTCLKCFG_CLKSEL_Pos) |
                                               	  	  RCU_UARTCLKCFG_CLKEN_Msk |
 													  RCU_UARTCLKCFG_RSTDIS_Msk;
-    RETARGET_UART->IBRD = baud_icoef;
-    RETARGET_UART->FBRD = baud_fcoef;
     RETARGET_UART->LCRH = UART_LCRH_FEN_Msk | (3 << UART_LCRH_WLEN_Pos);
+    retarget_set_baud();
+    // TX: прерывание при опустошении FIFO до 1/8, RX: при заполнении до 1/2 или по таймауту
+    RETARGET_UART->IFLS = (UART_IFLS_TXIFLSEL_Lvl18 << UART_IFLS_TXIFLSEL_Pos) |
+                          (UART_IFLS_RXIFLSEL_Lvl12 << UART_IFLS_RXIFLSEL_Pos);
+    RETARGET_UART->ICR = UART_ICR_RXIC_Msk | UART_ICR_RTIC_Msk | UART_ICR_TXIC_Msk;
+    RETARGET_UART->IMSC = UART_IMSC_RXIM_Msk | UART_IMSC_RTIM_Msk;
     RETARGET_UART->CR = UART_CR_TXE_Msk | UART_CR_RXE_Msk | UART_CR_UARTEN_Msk;
+
+    // Прерывания ядра разрешает InterruptEnable(), до этого буферы выгружаются опросом
+    SetIrqHandler(RETARGET_UART_IRQ_VECT, retarget_uart_irq, RETARGET_UART_IRQ_PRIORITY);
+#ifdef RETARGET_PERF
+    perf_notifier_register(&retarget_perf, retarget_perf_notify, NULL);
+#endif
 #endif //RETARGET
 }
 
 int retarget_get_char()
 {
 #if defined RETARGET
-    while (RETARGET_UART->FR_bit.RXFE) {
-    };
-    return (int)RETARGET_UART->DR_bit.DATA;
+    uint32_t tail = retarget_rx.tail;
+    int ch;
+
+    while (retarget_rx.head == tail) {
+        // Прерывание UART может быть недоступно не только при MIE = 0, но и внутри
+        // обработчика PLIC (порог MTHR, незавершенный claim), поэтому FIFO всегда
+        // выбирается и опросом
+        uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+        retarget_rx_drain();
+        csr_write_mstatus(mstatus);
+    }
+    ch = retarget_rx.data[tail & RETARGET_RX_MASK];
+    retarget_rx.tail = tail + 1;
+    return ch;
+#else
+    return -1;
 #endif //RETARGET
 }
 
-int retarget_put_char(int ch)
+int retarget_rx_available()
+{
+    return (int)(retarget_rx.head - retarget_rx.tail);
+}
+
+int retarget_write(const char *ptr, int len)
 {
 #if defined RETARGET
-    while (RETARGET_UART->FR_bit.BUSY) {
-    };
-    RETARGET_UART->DR = ch;
+    uint32_t start = (uint32_t)csr_read_mcycle();
+    int i = 0;
+
+    while (i < len) {
+        uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+        uint32_t head = retarget_tx.head;
+        uint32_t used = head - retarget_tx.tail;
+        uint32_t n = (uint32_t)(len - i);
+
+        if (used == RETARGET_TX_BUFFER_SIZE) {
+#if RETARGET_TX_POLICY == RETARGET_TX_POLICY_BLOCK
+            // Буфер освобождается и опросом: прерывание UART может быть недоступно
+            // (MIE = 0, вызов из обработчика PLIC)
+            retarget_tx_fill();
+            csr_write_mstatus(mstatus);
+            continue;
+#elif RETARGET_TX_POLICY == RETARGET_TX_POLICY_DROP
+            retarget_stats.tx_dropped += n;
+            csr_write_mstatus(mstatus);
+            break;
+#endif
+        }
+
+#if RETARGET_TX_POLICY == RETARGET_TX_POLICY_OVERWRITE
+        // Из данных длиннее буфера сохраняется только хвост
+        if (n > RETARGET_TX_BUFFER_SIZE) {
+            retarget_stats.tx_dropped += n - RETARGET_TX_BUFFER_SIZE;
+            i += n - RETARGET_TX_BUFFER_SIZE;
+            n = RETARGET_TX_BUFFER_SIZE;
+        }
+        if (n > RETARGET_TX_BUFFER_SIZE - used) {
+            uint32_t drop = n - (RETARGET_TX_BUFFER_SIZE - used);
+
+            retarget_tx.tail += drop;
+            retarget_stats.tx_dropped += drop;
+            used -= drop;
+        }
+#else
+        if (n > RETARGET_TX_BUFFER_SIZE - used)
+            n = RETARGET_TX_BUFFER_SIZE - used;
+#endif
+
+        for (uint32_t k = 0; k < n; k++)
+            retarget_tx.data[(head + k) & RETARGET_TX_MASK] = ptr[i + k];
+        retarget_tx.head = head + n;
+        i += n;
+
+        used += n;
+        if (used > retarget_stats.tx_high_water)
+            retarget_stats.tx_high_water = used;
+
+        retarget_tx_fill();
+        csr_write_mstatus(mstatus);
+    }
+
+    retarget_stats.tx_bytes += len;
+    retarget_stats.write_cycles += (uint32_t)csr_read_mcycle() - start;
 #endif //RETARGET
+    return len;
+}
+
+int retarget_put_char(int ch)
+{
+    char c = (char)ch;
+
+    retarget_write(&c, 1);
     return 0;
 }
 
-#ifdef USE_LIBC
+void retarget_flush()
+{
+#if defined RETARGET
+    while (retarget_tx.head != retarget_tx.tail || (RETARGET_UART->FR & UART_FR_BUSY_Msk)) {
+        uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
 
-// Переопределяем системный вызов write для libc nano
-int _write(int file, char *ptr, int len) {
-    for (int i = 0; i < len; i++) {
-    	retarget_put_char(ptr[i]);
+        retarget_tx_fill();
+        csr_write_mstatus(mstatus);
     }
-    return len;
+#endif //RETARGET
 }
 
-void *_sbrk(ptrdiff_t incr)
+void retarget_stats_reset()
 {
-    extern char _ebss[];
-    static char *heap_end = _ebss;
-    char *base = heap_end;
-    heap_end += incr;
-    return base;
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    retarget_stats.tx_bytes = 0;
+    retarget_stats.tx_dropped = 0;
+    retarget_stats.tx_high_water = 0;
+    retarget_stats.rx_bytes = 0;
+    retarget_stats.rx_dropped = 0;
+    retarget_stats.write_cycles = 0;
+
+    csr_write_mstatus(mstatus);
 }
 
+#ifdef USE_LIBC
+
+// Переопределяем системный вызов write для libc nano
+int _write(int file, char *ptr, int len) {
+    (void)file;
+    return retarget_write(ptr, len);
+}
+
+// _sbrk() с проверкой границы стека - в mem_stats.c
+
 // Обработчик для errno (может потребоваться)
 __attribute__((weak)) int _getpid(void) {
     return 1;
@@ -23,7 +23,6 @@
 
 #include <K1921VG015.h>
 #include <stdio.h>
-#include <unistd.h>
 #include <stdint.h>
 #include <errno.h>
 
@@ -34,14 +33,66 @@
 #define RETARGET_UART_PIN_RX_POS 0
 #define RETARGET_UART_RX_IRQHandler UART0_IRQHandler
 #define RETARGET_UART_RX_IRQn UART0_IRQn
+#define RETARGET_UART_IRQ_VECT IsrVect_IRQ_UART0
+#define RETARGET_UART_IRQ_PRIORITY 1
 
 #define RETARGET_UART_BAUD 115200
 
+/** Источник тактирования UART (RCU_UARTCLKCFG_CLKSEL_*). HSE не зависит от
+ * perf_set_level(); при тактировании от PLL делители скорости пересчитываются
+ * уведомлением perf, если задан RETARGET_PERF.
+ */
+#ifndef RETARGET_UART_CLKSEL
+#define RETARGET_UART_CLKSEL RCU_UARTCLKCFG_CLKSEL_HSE
+#endif
+
+/** Размеры кольцевых буферов передачи и приема (степень двойки).
+ * Передача идет из прерывания UART, retarget_put_char() только кладет байт в
+ * буфер и не ждет освобождения передатчика.
+ */
+#ifndef RETARGET_TX_BUFFER_SIZE
+#define RETARGET_TX_BUFFER_SIZE 512
+#endif
+#ifndef RETARGET_RX_BUFFER_SIZE
+#define RETARGET_RX_BUFFER_SIZE 64
+#endif
+
+/** Поведение при заполненном буфере передачи:
+ * BLOCK     - ждать освобождения места (буфер выгружается и опросом, так что
+ *             ожидание завершается и из обработчика прерывания);
+ * DROP      - отбросить новый байт;
+ * OVERWRITE - отбросить самый старый байт из буфера.
+ */
+#define RETARGET_TX_POLICY_BLOCK     0
+#define RETARGET_TX_POLICY_DROP      1
+#define RETARGET_TX_POLICY_OVERWRITE 2
+
+#ifndef RETARGET_TX_POLICY
+#define RETARGET_TX_POLICY RETARGET_TX_POLICY_BLOCK
+#endif
+
+/** Статистика буферов, время в тактах mcycle.
+ */
+typedef struct {
+    uint32_t tx_bytes;       // Байт, записанных через _write()/retarget_put_char()
+    uint32_t tx_dropped;     // Байт, потерянных по политике DROP/OVERWRITE
+    uint32_t tx_high_water;  // Максимальное заполнение буфера передачи
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;     // Байт, не поместившихся в буфер приема
+    uint64_t write_cycles;   // Время CPU внутри _write()
+} retarget_stats_t;
+
+extern volatile retarget_stats_t retarget_stats;
+
 
 //-- Functions -----------------------------------------------------------------
 void retarget_init(void);
 int retarget_get_char(void);
 int retarget_put_char(int ch);
+int retarget_write(const char *ptr, int len);
+int retarget_rx_available(void);
+void retarget_flush(void);
+void retarget_stats_reset(void);
 
 
 #endif /* BSP_INCLUDE_RETARGET_H_ */
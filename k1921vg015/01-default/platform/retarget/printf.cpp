@@ -0,0 +1,296 @@
+/**************************************************************************//*****
+ * @file     printf.cpp
+ * @brief    Implementation of several stdio.h methods, such as printf(),
+ *           sprintf() and so on. This reduces the memory footprint of the
+ *           binary when using those methods, compared to the libc implementation.
+ *           The formatting is done by format.h, C++ code should call
+ *           fmt::format_to() directly to have the format string checked and
+ *           parsed at compile time.
+ *
+ *           By default only 32-bit integers, %c, %s and %p are formatted:
+ *           %f, %lld and %jd are copied to the output as they are (their
+ *           argument is skipped), this keeps the float and 64-bit division
+ *           code out of the binary. Define FMT_RUNTIME_FULL to format them.
+ *
+ *           NOTE: even then %f is NOT the C library %f. The FPU is single
+ *           precision, so the double argument is converted to float first:
+ *           printf("%f", 123456789.0) prints 123456792.000000, and only 9
+ *           fraction digits are computed, "%.12f" pads the rest with zeros.
+ *           Use fmt::fixed or integers where the exact digits matter.
+ ********************************************************************************/
+#ifndef USE_LIBC
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "format.h"
+
+extern "C" {
+
+#include "retarget.h"
+
+
+/**
+ * @brief  Transmit a char, if you want to use printf(),
+ *         you need implement this function
+ *
+ * @param  pStr	Storage string.
+ * @param  c    Character to write.
+ */
+void PrintChar(char c)
+{
+	retarget_put_char(c);
+}
+
+/** Maximum string size allowed (in bytes). */
+#define MAX_STRING_SIZE         100
+
+
+/** Required for proper compilation. */
+struct _reent r = {0, (FILE *) 0, (FILE *) 1, (FILE *) 0};
+struct _reent *_impure_ptr = &r;
+
+
+/**
+ * @brief  Sends a piece of formatted output to stdout.
+ *
+ * @param  pData  Characters to write.
+ * @param  size   Number of characters.
+ */
+static void PrintData(const char *pData, size_t size)
+{
+    retarget_write(pData, (int)size);
+}
+
+
+/* Global Functions ----------------------------------------------------------- */
+
+
+/**
+ * @brief  Stores the result of a formatted string into another string. Format
+ *         arguments are given in a va_list instance.
+ *
+ * @param pStr    Destination string.
+ * @param length  Length of Destination string.
+ * @param pFormat Format string.
+ * @param ap      Argument list.
+ *
+ * @return  The number of characters of the whole output (C99), at most
+ *          length - 1 of them are stored. Unsupported conversions are copied
+ *          to the output as they are.
+ */
+signed int vsnprintf(char *pStr, size_t length, const char *pFormat, va_list ap)
+{
+    fmt::buffer_output out(pStr, pStr ? length : 0);
+    signed int size = fmt::vformat(out, pFormat, ap);
+
+    out.finish();
+
+    return size;
+}
+
+
+/**
+ * @brief  Stores the result of a formatted string into another string. Format
+ *         arguments are given in a va_list instance.
+ *
+ * @param pStr    Destination string.
+ * @param length  Length of Destination string.
+ * @param pFormat Format string.
+ * @param ...     Other arguments
+ *
+ * @return  The number of characters written.
+ */
+signed int snprintf(char *pString, size_t length, const char *pFormat, ...)
+{
+    va_list    ap;
+    signed int rc;
+
+    va_start(ap, pFormat);
+    rc = vsnprintf(pString, length, pFormat, ap);
+    va_end(ap);
+
+    return rc;
+}
+
+
+/**
+ * @brief  Stores the result of a formatted string into another string. Format
+ *         arguments are given in a va_list instance.
+ *
+ * @param pString  Destination string.
+ * @param length   Length of Destination string.
+ * @param pFormat  Format string.
+ * @param ap       Argument list.
+ *
+ * @return  The number of characters written.
+ */
+signed int vsprintf(char *pString, const char *pFormat, va_list ap)
+{
+   return vsnprintf(pString, MAX_STRING_SIZE, pFormat, ap);
+}
+
+/**
+ * @brief  Outputs a formatted string on the given stream. Format arguments are given
+ *         in a va_list instance.
+ *
+ * @param pStream  Output stream.
+ * @param pFormat  Format string
+ * @param ap       Argument list.
+ */
+signed int vfprintf(FILE *pStream, const char *pFormat, va_list ap)
+{
+    if ((pStream != stdout) && (pStream != stderr)) {
+
+        return EOF;
+    }
+
+    fmt::stream_output<void (*)(const char *, size_t)> out(PrintData);
+    signed int size = fmt::vformat(out, pFormat, ap);
+
+    out.flush();
+
+    return size;
+}
+
+
+/**
+ * @brief  Outputs a formatted string on the DBGU stream. Format arguments are given
+ *         in a va_list instance.
+ *
+ * @param pFormat  Format string.
+ * @param ap  Argument list.
+ */
+signed int vprintf(const char *pFormat, va_list ap)
+{
+    return vfprintf(stdout, pFormat, ap);
+}
+
+
+/**
+ * @brief  Outputs a formatted string on the given stream, using a variable
+ *         number of arguments.
+ *
+ * @param pStream  Output stream.
+ * @param pFormat  Format string.
+ */
+signed int fprintf(FILE *pStream, const char *pFormat, ...)
+{
+    va_list ap;
+    signed int result;
+
+    /* Forward call to vfprintf */
+    va_start(ap, pFormat);
+    result = vfprintf(pStream, pFormat, ap);
+    va_end(ap);
+
+    return result;
+}
+
+
+/**
+ * @brief  Outputs a formatted string on the DBGU stream, using a variable number of
+ *         arguments.
+ *
+ * @param  pFormat  Format string.
+ */
+signed int printf(const char *pFormat, ...)
+{
+    va_list ap;
+    signed int result;
+
+    /* Forward call to vprintf */
+    va_start(ap, pFormat);
+    result = vprintf(pFormat, ap);
+    va_end(ap);
+
+    return result;
+}
+
+
+/**
+ * @brief  Writes a formatted string inside another string.
+ *
+ * @param pStr     torage string.
+ * @param pFormat  Format string.
+ */
+signed int sprintf(char *pStr, const char *pFormat, ...)
+{
+    va_list ap;
+    signed int result;
+
+    // Forward call to vsprintf
+    va_start(ap, pFormat);
+    result = vsprintf(pStr, pFormat, ap);
+    va_end(ap);
+
+    return result;
+}
+
+
+/**
+ * @brief  Outputs a string on stdout.
+ *
+ * @param pStr  String to output.
+ */
+signed int puts(const char *pStr)
+{
+    signed int i = fputs(pStr, stdout);
+    fputc('\n', stdout);
+
+    return i+1;
+}
+
+
+/**
+ * @brief  Implementation of fputc using the DBGU as the standard output. Required
+ *         for printf().
+ *
+ * @param c        Character to write.
+ * @param pStream  Output stream.
+ * @param The character written if successful, or -1 if the output stream is
+ *        not stdout or stderr.
+ */
+signed int fputc(signed int c, FILE *pStream)
+{
+    if ((pStream == stdout) || (pStream == stderr)) {
+
+    	PrintChar(c);
+
+        return c;
+    }
+    else {
+
+        return EOF;
+    }
+}
+
+
+/**
+ * @brief  Implementation of fputs using the DBGU as the standard output. Required
+ *         for printf().
+ *
+ * @param pStr     String to write.
+ * @param pStream  Output stream.
+ *
+ * @return  Number of characters written if successful, or -1 if the output
+ *          stream is not stdout or stderr.
+ */
+signed int fputs(const char *pStr, FILE *pStream)
+{
+    signed int num = 0;
+
+    while (*pStr != 0) {
+
+        if (fputc(*pStr, pStream) == -1) {
+
+            return -1;
+        }
+        num++;
+        pStr++;
+    }
+
+    return num;
+}
+} // extern "C"
+#endif
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,55 @@
+#include "rtt_channel.h"
+
+volatile rtt_channel_stats_t rtt_channel_stats[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
+static uint32_t rtt_channel_pool[RTT_CHANNEL_POOL_SIZE / 4] __attribute__((section(".ram1.bss.rtt_channel_pool")));
+static uint32_t rtt_channel_pool_used;
+
+int rtt_channel_setup(unsigned channel, const char *name, unsigned size, unsigned mode)
+{
+    void *buffer = 0;
+
+    if (channel >= SEGGER_RTT_MAX_NUM_UP_BUFFERS) return -1;
+
+    // SEGGER_RTT_ConfigUpBuffer() ignores the buffer of the terminal channel
+    if (channel != RTT_CHANNEL_TERMINAL) {
+        size = (size + 3) & ~3u;
+
+        if (size > sizeof(rtt_channel_pool) - rtt_channel_pool_used) return -1;
+
+        buffer = (char *)rtt_channel_pool + rtt_channel_pool_used;
+        rtt_channel_pool_used += size;
+    }
+
+    rtt_channel_stats[channel].written = 0;
+    rtt_channel_stats[channel].dropped = 0;
+    rtt_channel_stats[channel].high_water = 0;
+
+    return SEGGER_RTT_ConfigUpBuffer(channel, name, buffer, size, mode);
+}
+
+unsigned rtt_channel_write(unsigned channel, const void *data, unsigned size)
+{
+    unsigned stored;
+
+    SEGGER_RTT_LOCK();
+    stored = SEGGER_RTT_WriteNoLock(channel, data, size);
+    rtt_channel_account(channel, stored, size);
+    SEGGER_RTT_UNLOCK();
+
+    return stored;
+}
+
+void rtt_channel_poll(void)
+{
+    for (unsigned channel = 0; channel < SEGGER_RTT_MAX_NUM_UP_BUFFERS; channel++) {
+        SEGGER_RTT_LOCK();
+        rtt_channel_account(channel, 0, 0);
+        SEGGER_RTT_UNLOCK();
+    }
+}
+
+unsigned rtt_channel_pool_free(void)
+{
+    return sizeof(rtt_channel_pool) - rtt_channel_pool_used;
+}
@@ -0,0 +1,87 @@
+#ifndef RTT_CHANNEL_H
+#define RTT_CHANNEL_H
+
+#include <stdint.h>
+
+#include "SEGGER_RTT.h"
+
+/** RTT up-channel registry.
+ *
+ * Channel buffers are allocated from a pool in RAM1 (section .ram1.bss, not
+ * cleared by the startup code), the terminal buffers of SEGGER_RTT.c are put
+ * there too (SEGGER_RTT_BUFFER_SECTION). Every up-channel has counters in
+ * rtt_channel_stats[], the host reads them by symbol through the debug probe
+ * in the same way as the RTT control block.
+ *
+ * Writes through rtt_channel_write(), rtt_sp_write() and RTT_LOG() are
+ * accounted. Channels written through the plain SEGGER API (e.g. the terminal
+ * via SEGGER_RTT_printf()) only get their high-water mark from
+ * rtt_channel_poll().
+ */
+
+#define RTT_CHANNEL_TERMINAL  0
+#define RTT_CHANNEL_BENCH     1
+#define RTT_CHANNEL_LOG       2
+#define RTT_CHANNEL_PROF      3
+#define RTT_CHANNEL_TRACE     4
+
+/** Size of the RAM1 buffer pool in bytes.
+ */
+#ifndef RTT_CHANNEL_POOL_SIZE
+#define RTT_CHANNEL_POOL_SIZE (16 * 1024)
+#endif
+
+typedef struct {
+    uint32_t written;     // Bytes stored in the ring
+    uint32_t dropped;     // Bytes skipped or trimmed because the ring was full
+    uint32_t high_water;  // Maximum fill level in bytes
+} rtt_channel_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile rtt_channel_stats_t rtt_channel_stats[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
+/** Configure an up-channel and allocate its buffer from the pool.
+ * The terminal channel keeps its static buffer, only the mode is changed.
+ * A channel is set up once, the pool memory is never freed.
+ * @param size Buffer size in bytes, rounded up to a multiple of 4.
+ * @param mode SEGGER_RTT_MODE_*.
+ * @return 0 on success, -1 if the channel does not exist or the pool is exhausted.
+ */
+int rtt_channel_setup(unsigned channel, const char *name, unsigned size, unsigned mode);
+
+/** Write under the RTT lock according to the channel mode and update the counters.
+ * @return Number of bytes stored.
+ */
+unsigned rtt_channel_write(unsigned channel, const void *data, unsigned size);
+
+/** Sample the fill level of all up-channels into their high-water marks.
+ */
+void rtt_channel_poll(void);
+
+/** Bytes left in the pool.
+ */
+unsigned rtt_channel_pool_free(void);
+
+/** Update the counters after a write, called by the owner of the channel
+ * (under the RTT lock or from its single producer context).
+ */
+static inline void rtt_channel_account(unsigned channel, unsigned stored, unsigned requested) {
+    const SEGGER_RTT_BUFFER_UP *ring = &_SEGGER_RTT.aUp[channel];
+    volatile rtt_channel_stats_t *stats = &rtt_channel_stats[channel];
+    unsigned rd = ring->RdOff;
+    unsigned wr = ring->WrOff;
+    unsigned fill = wr >= rd ? wr - rd : wr + ring->SizeOfBuffer - rd;
+
+    stats->written += stored;
+    stats->dropped += requested - stored;
+    if (fill > stats->high_water) stats->high_water = fill;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTT_CHANNEL_H
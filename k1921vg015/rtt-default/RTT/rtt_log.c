@@ -0,0 +1,65 @@
+#include "rtt_log.h"
+#include "riscv-csr.h"
+#include "mtimer.h"
+
+#if (RTT_LOG_BUFFER_SIZE % 4) != 0
+#error "RTT_LOG_BUFFER_SIZE must be a multiple of 4"
+#endif
+
+#if RTT_LOG_CHANNEL >= SEGGER_RTT_MAX_NUM_UP_BUFFERS
+#error "RTT_LOG_CHANNEL exceeds SEGGER_RTT_MAX_NUM_UP_BUFFERS"
+#endif
+
+volatile uint32_t rtt_log_dropped;
+
+void rtt_log_init(void)
+{
+    rtt_channel_setup(RTT_LOG_CHANNEL, "Log", RTT_LOG_BUFFER_SIZE, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+/** The ring holds whole words only: WrOff and the record length are multiples
+ * of 4, so a record may wrap between two words but never inside one.
+ */
+void rtt_log_emit(uint32_t header, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    SEGGER_RTT_BUFFER_UP *ring = &_SEGGER_RTT.aUp[RTT_LOG_CHANNEL];
+    uint32_t *buffer = (uint32_t *)ring->pBuffer;
+    uint32_t words = 2 + (header >> 28);
+    uint32_t record[2 + RTT_LOG_MAX_ARGS];
+
+    record[2] = a0;
+    record[3] = a1;
+    record[4] = a2;
+    record[5] = a3;
+
+    // The record is stored under the lock, so the timestamps follow the ring order
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    __asm volatile ("" : : : "memory");
+
+    unsigned rd = ring->RdOff;
+    unsigned wr = ring->WrOff;
+    unsigned size = ring->SizeOfBuffer;
+    unsigned avail = (rd > wr ? rd : rd + size) - wr - 1;
+
+    // An unconfigured channel has no buffer, the records are dropped until rtt_log_init()
+    if (size != 0 && words * 4 <= avail) {
+        record[0] = header;
+        record[1] = *(volatile uint32_t *)RISCV_MTIME_ADDR;
+
+        for (uint32_t i = 0; i < words; i++) {
+            buffer[wr / 4] = record[i];
+            wr += 4;
+            if (wr == size) wr = 0;
+        }
+
+        RTT__DMB();
+        ring->WrOff = wr;
+        rtt_channel_account(RTT_LOG_CHANNEL, words * 4, words * 4);
+    } else {
+        rtt_log_dropped++;
+        rtt_channel_account(RTT_LOG_CHANNEL, 0, words * 4);
+    }
+
+    __asm volatile ("" : : : "memory");
+    csr_set_bits_mstatus(mstatus & MSTATUS_MIE_BIT_MASK);
+}
@@ -0,0 +1,77 @@
+#ifndef RTT_LOG_H
+#define RTT_LOG_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "rtt_channel.h"
+
+/** Deferred binary logging over RTT.
+ *
+ * RTT_LOG() does not format anything on the target. Each call stores a record
+ * of 32-bit words in its own up-channel:
+ *
+ *   word 0     format ID | (number of arguments << 28)
+ *   word 1     low word of mtime
+ *   word 2..5  raw arguments
+ *
+ * The format string itself goes to the non-loaded section .rtt_log_fmt, the
+ * ID is its address in that section. tools/rtt_log_decode.py rebuilds the text
+ * from the ELF file. A call takes a few tens of cycles and may be used in
+ * interrupt handlers.
+ *
+ * Arguments are passed as 32-bit words: integers, characters and pointers.
+ * %s is resolved by the decoder, so the string must be a constant in the ELF
+ * image. Floating point arguments are not supported.
+ */
+
+#ifndef RTT_LOG_CHANNEL
+#define RTT_LOG_CHANNEL      RTT_CHANNEL_LOG
+#endif
+
+/** Size of the log ring in bytes, must be a multiple of 4.
+ */
+#ifndef RTT_LOG_BUFFER_SIZE
+#define RTT_LOG_BUFFER_SIZE  1024
+#endif
+
+#define RTT_LOG_MAX_ARGS     4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of records dropped because the ring was full.
+ */
+extern volatile uint32_t rtt_log_dropped;
+
+/** Configure the log up-channel, the buffer is taken from the channel pool.
+ */
+void rtt_log_init(void);
+
+/** Store one record, use RTT_LOG() instead.
+ */
+void rtt_log_emit(uint32_t header, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define RTT_LOG_ARG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define RTT_LOG_ARG_COUNT(...)  RTT_LOG_ARG_COUNT_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define RTT_LOG_ARGS_(_0, A0, A1, A2, A3, ...) \
+    (uint32_t)(uintptr_t)(A0), (uint32_t)(uintptr_t)(A1), (uint32_t)(uintptr_t)(A2), (uint32_t)(uintptr_t)(A3)
+
+/** Log a message with up to RTT_LOG_MAX_ARGS arguments, e.g.
+ * RTT_LOG("irq %u: %x", num, value);
+ */
+#define RTT_LOG(FMT, ...)                                                                     \
+    do {                                                                                      \
+        static const char rtt_log_fmt_[] __attribute__((section(".rtt_log_fmt"), used)) = FMT; \
+        static_assert(RTT_LOG_ARG_COUNT(__VA_ARGS__) <= RTT_LOG_MAX_ARGS, "too many arguments"); \
+        rtt_log_emit((uint32_t)(uintptr_t)rtt_log_fmt_ | ((uint32_t)RTT_LOG_ARG_COUNT(__VA_ARGS__) << 28), \
+                     RTT_LOG_ARGS_(0, ##__VA_ARGS__, 0, 0, 0, 0, 0));                            \
+    } while (0)
+
+#endif // RTT_LOG_H
@@ -0,0 +1,67 @@
+#include <stdint.h>
+
+#include "rtt_memcpy.h"
+
+typedef uint32_t __attribute__((may_alias)) rtt_word_t;
+
+/** Shorter copies are not worth the alignment setup.
+ */
+#define RTT_MEMCPY_WORD_MIN 8
+
+// Keep GCC from turning the loops back into a memcpy() call
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void *rtt_memcpy(void *dst, const void *src, unsigned size)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+    if (size >= RTT_MEMCPY_WORD_MIN) {
+        // Head: align the destination
+        while ((uintptr_t)d & 3) {
+            *d++ = *s++;
+            size--;
+        }
+
+        rtt_word_t *dw = (rtt_word_t *)d;
+        unsigned words = size / 4;
+        unsigned shift = ((uintptr_t)s & 3) * 8;
+
+        if (shift == 0) {
+            const rtt_word_t *sw = (const rtt_word_t *)s;
+
+            for (; words >= 4; words -= 4) {
+                uint32_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+
+                dw[0] = w0;
+                dw[1] = w1;
+                dw[2] = w2;
+                dw[3] = w3;
+                dw += 4;
+                sw += 4;
+            }
+
+            for (; words; words--) *dw++ = *sw++;
+        } else {
+            // The last load is the aligned word holding the last source byte, it never
+            // reaches past the end of the source region
+            const rtt_word_t *sw = (const rtt_word_t *)((uintptr_t)s & ~(uintptr_t)3);
+            uint32_t lo = *sw++;
+
+            for (; words; words--) {
+                uint32_t hi = *sw++;
+
+                *dw++ = (lo >> shift) | (hi << (32 - shift));
+                lo = hi;
+            }
+        }
+
+        s += size & ~3u;
+        d = (uint8_t *)dw;
+        size &= 3;
+    }
+
+    // Tail
+    while (size--) *d++ = *s++;
+
+    return dst;
+}
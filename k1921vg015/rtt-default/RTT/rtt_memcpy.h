@@ -0,0 +1,21 @@
+#ifndef RTT_MEMCPY_H
+#define RTT_MEMCPY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Copy for the RTT ring writes (SEGGER_RTT_MEMCPY).
+ *
+ * The build uses -fno-builtin and -mstrict-align, so memcpy() is never
+ * inlined and newlib falls back to byte copies for most RTT payloads. This
+ * copy aligns the destination and then moves 32-bit words, a misaligned
+ * source is read with aligned loads and merged with shifts.
+ */
+void *rtt_memcpy(void *dst, const void *src, unsigned size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTT_MEMCPY_H
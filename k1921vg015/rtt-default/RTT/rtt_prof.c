@@ -0,0 +1,107 @@
+#include "rtt_prof.h"
+#include "rtt_sp.h"
+#include "riscv-csr.h"
+#include "swtimer.h"
+#ifdef MTIMER_DYNAMIC_FREQ
+#include "perf.h"
+#endif
+
+#if RTT_PROF_CHANNEL >= SEGGER_RTT_MAX_NUM_UP_BUFFERS
+#error "RTT_PROF_CHANNEL exceeds SEGGER_RTT_MAX_NUM_UP_BUFFERS"
+#endif
+
+volatile rtt_prof_stats_t rtt_prof_stats;
+
+static swtimer_t rtt_prof_timer;
+static uint32_t rtt_prof_rate;   // 0 while stopped
+
+void rtt_prof_stats_reset(void)
+{
+    rtt_prof_stats.samples = 0;
+    rtt_prof_stats.dropped = 0;
+    rtt_prof_stats.last_cycles = 0;
+    rtt_prof_stats.max_cycles = 0;
+    rtt_prof_stats.sum_cycles = 0;
+}
+
+/** Called from swtimer_process() in the machine timer interrupt, so mepc is
+ * the preempted PC and the channel has a single producer.
+ */
+static void rtt_prof_sample(swtimer_t *timer, void *arg)
+{
+    uint32_t start = (uint32_t)csr_read_mcycle();
+    uint32_t pc = (uint32_t)csr_read_mepc();
+
+    (void)timer;
+    (void)arg;
+
+    if (rtt_sp_write(RTT_PROF_CHANNEL, &pc, sizeof(pc))) {
+        rtt_prof_stats.samples++;
+    } else {
+        rtt_prof_stats.dropped++;
+    }
+
+    uint32_t cycles = (uint32_t)csr_read_mcycle() - start;
+
+    rtt_prof_stats.last_cycles = cycles;
+    rtt_prof_stats.sum_cycles += cycles;
+    if (cycles > rtt_prof_stats.max_cycles) rtt_prof_stats.max_cycles = cycles;
+}
+
+/** Timer period for the rate at the current mtime frequency.
+ */
+static uint32_t rtt_prof_period(uint32_t rate_hz)
+{
+    uint32_t period = (uint32_t)SWTIMER_CLOCKS_TO_TICKS(MTIME_FREQ_HZ / rate_hz);
+
+    return period ? period : 1;
+}
+
+#ifdef MTIMER_DYNAMIC_FREQ
+static perf_notifier_t rtt_prof_perf;
+
+/** mtime runs at the new SYSCLK after a level switch, the period in ticks is
+ * recomputed so the sampling rate stays the same.
+ */
+static void rtt_prof_perf_notify(perf_notifier_t *notifier, perf_event_t event, uint32_t hz)
+{
+    (void)notifier;
+    (void)hz;
+
+    if (event == PERF_POST_CHANGE && rtt_prof_rate) {
+        uint32_t period = rtt_prof_period(rtt_prof_rate);
+
+        swtimer_start(&rtt_prof_timer, period, period);
+    }
+}
+#endif
+
+void rtt_prof_init(void)
+{
+    rtt_channel_setup(RTT_PROF_CHANNEL, "Prof", RTT_PROF_BUFFER_SIZE, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    swtimer_setup(&rtt_prof_timer, rtt_prof_sample, 0);
+#ifdef MTIMER_DYNAMIC_FREQ
+    perf_notifier_register(&rtt_prof_perf, rtt_prof_perf_notify, 0);
+#endif
+}
+
+void rtt_prof_start(uint32_t rate_hz)
+{
+    if (rate_hz == 0) rate_hz = RTT_PROF_RATE_HZ;
+
+    uint32_t period = rtt_prof_period(rate_hz);
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    rtt_prof_rate = rate_hz;
+    swtimer_start(&rtt_prof_timer, period, period);
+    csr_write_mstatus(mstatus);
+}
+
+void rtt_prof_stop(void)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    rtt_prof_rate = 0;
+    swtimer_stop(&rtt_prof_timer);
+    csr_write_mstatus(mstatus);
+}
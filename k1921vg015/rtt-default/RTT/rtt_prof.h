@@ -0,0 +1,75 @@
+#ifndef RTT_PROF_H
+#define RTT_PROF_H
+
+#include <stdint.h>
+
+#include "rtt_channel.h"
+
+/** Statistical profiler: samples mepc from the machine timer interrupt.
+ *
+ * A periodic software timer (swtimer, i.e. mtimecmp and the MTI handler
+ * installed with riscv_irq_set_handler()) reads mepc, the PC the timer
+ * interrupt has preempted, and writes it as one 32-bit word to its own RTT
+ * up-channel. tools/rtt_prof.py maps the samples to the ELF symbols and
+ * prints a flat profile or folded stacks for flamegraph.pl.
+ *
+ * Samples taken while a PLIC handler runs with nesting enabled
+ * (PLIC_NESTED_IRQ) point into that handler. Time with global interrupts
+ * masked is charged to the instruction that unmasks them. Do not poll
+ * swtimer_process() while profiling, mepc is only valid inside the trap.
+ */
+
+#ifndef RTT_PROF_CHANNEL
+#define RTT_PROF_CHANNEL      RTT_CHANNEL_PROF
+#endif
+
+#ifndef RTT_PROF_BUFFER_SIZE
+#define RTT_PROF_BUFFER_SIZE  2048
+#endif
+
+/** Default sampling rate, the resolution is one swtimer tick (SWTIMER_TICK_SHIFT).
+ */
+#ifndef RTT_PROF_RATE_HZ
+#define RTT_PROF_RATE_HZ      1000
+#endif
+
+/** Sampling statistics, the cycle counts are taken from mcycle.
+ */
+typedef struct {
+    uint32_t samples;        // Samples stored
+    uint32_t dropped;        // Samples lost because the ring was full
+    uint32_t last_cycles;    // Cycles of the last sample (read mepc and write to RTT)
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+} rtt_prof_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile rtt_prof_stats_t rtt_prof_stats;
+
+/** Configure the profiler up-channel, the buffer is taken from the channel pool.
+ */
+void rtt_prof_init(void);
+
+/** Start sampling, swtimer_init() must have been called. With
+ * MTIMER_DYNAMIC_FREQ the period is recomputed after each perf_set_level(),
+ * otherwise it is fixed for MTIME_FREQ_HZ and the rate follows SYSCLK.
+ * @param rate_hz Sampling rate, 0 for RTT_PROF_RATE_HZ.
+ */
+void rtt_prof_start(uint32_t rate_hz);
+
+/** Stop sampling.
+ */
+void rtt_prof_stop(void);
+
+/** Reset the sampling statistics.
+ */
+void rtt_prof_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTT_PROF_H
@@ -0,0 +1,276 @@
+#include "rtt_shell.h"
+#include "rtt_channel.h"
+
+#define RTT_SHELL_PROMPT "> "
+
+static struct {
+    const rtt_shell_command_t *commands;    // Application commands
+    unsigned count;
+    unsigned length;                        // Characters in line
+    bool overflow;                          // The line was longer than the buffer
+    char line[RTT_SHELL_LINE_SIZE];
+} rtt_shell;
+
+void rtt_shell_puts(const char *s)
+{
+    unsigned length = 0;
+
+    while (s[length]) length++;
+
+    rtt_channel_write(RTT_CHANNEL_TERMINAL, s, length);
+}
+
+void rtt_shell_put_dec(uint32_t value)
+{
+    char buffer[11];
+    char *p = buffer + sizeof(buffer) - 1;
+
+    *p = 0;
+
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    rtt_shell_puts(p);
+}
+
+void rtt_shell_put_hex(uint32_t value)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char buffer[11];
+
+    buffer[0] = '0';
+    buffer[1] = 'x';
+    for (int i = 0; i < 8; i++) buffer[2 + i] = digits[(value >> (28 - 4 * i)) & 0xF];
+    buffer[10] = 0;
+
+    rtt_shell_puts(buffer);
+}
+
+bool rtt_shell_parse_u32(const char *s, uint32_t *value)
+{
+    uint32_t base = 10;
+    uint32_t result = 0;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
+
+    if (*s == 0) return false;
+
+    for (; *s; s++) {
+        uint32_t digit;
+
+        if (*s >= '0' && *s <= '9') digit = *s - '0';
+        else if (*s >= 'a' && *s <= 'f') digit = *s - 'a' + 10;
+        else if (*s >= 'A' && *s <= 'F') digit = *s - 'A' + 10;
+        else return false;
+
+        if (digit >= base) return false;
+        if (result > (UINT32_MAX - digit) / base) return false;
+
+        result = result * base + digit;
+    }
+
+    *value = result;
+
+    return true;
+}
+
+static bool rtt_shell_streq(const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+
+    return *a == *b;
+}
+
+static int rtt_shell_help(int argc, char *argv[]);
+
+/** peek <addr> [words], at most RTT_SHELL_PEEK_MAX words and never past the top of the address space
+ */
+static int rtt_shell_peek(int argc, char *argv[])
+{
+    uint32_t addr, count = 1;
+
+    if (argc < 2 || !rtt_shell_parse_u32(argv[1], &addr) || (addr & 3)) return -1;
+    if (argc > 2 && !rtt_shell_parse_u32(argv[2], &count)) return -1;
+
+    if (count > RTT_SHELL_PEEK_MAX) count = RTT_SHELL_PEEK_MAX;
+
+    for (uint32_t i = 0; i < count; i++, addr += 4) {
+        rtt_shell_put_hex(addr);
+        rtt_shell_puts(": ");
+        rtt_shell_put_hex(*(volatile uint32_t *)addr);
+        rtt_shell_puts("\n");
+
+        if (addr == UINT32_MAX - 3) break;
+    }
+
+    return 0;
+}
+
+/** poke <addr> <value>
+ */
+static int rtt_shell_poke(int argc, char *argv[])
+{
+    uint32_t addr, value;
+
+    if (argc != 3 || !rtt_shell_parse_u32(argv[1], &addr) || (addr & 3) || !rtt_shell_parse_u32(argv[2], &value)) return -1;
+
+    *(volatile uint32_t *)addr = value;
+
+    return 0;
+}
+
+/** rtt: counters of the up-channels
+ */
+static int rtt_shell_rtt(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    rtt_channel_poll();
+
+    for (unsigned channel = 0; channel < SEGGER_RTT_MAX_NUM_UP_BUFFERS; channel++) {
+        const SEGGER_RTT_BUFFER_UP *ring = &_SEGGER_RTT.aUp[channel];
+
+        rtt_shell_put_dec(channel);
+        rtt_shell_puts(" ");
+        rtt_shell_puts(ring->sName ? ring->sName : "-");
+        rtt_shell_puts(": size ");
+        rtt_shell_put_dec(ring->SizeOfBuffer);
+        rtt_shell_puts(", written ");
+        rtt_shell_put_dec(rtt_channel_stats[channel].written);
+        rtt_shell_puts(", dropped ");
+        rtt_shell_put_dec(rtt_channel_stats[channel].dropped);
+        rtt_shell_puts(", high water ");
+        rtt_shell_put_dec(rtt_channel_stats[channel].high_water);
+        rtt_shell_puts("\n");
+    }
+
+    return 0;
+}
+
+static const rtt_shell_command_t rtt_shell_builtins[] = {
+    { "help", "list commands", rtt_shell_help },
+    { "peek", "<addr> [words] read memory", rtt_shell_peek },
+    { "poke", "<addr> <value> write a word", rtt_shell_poke },
+    { "rtt",  "RTT channel counters", rtt_shell_rtt },
+};
+
+#define RTT_SHELL_BUILTINS (sizeof(rtt_shell_builtins) / sizeof(rtt_shell_builtins[0]))
+
+static void rtt_shell_put_usage(const rtt_shell_command_t *command)
+{
+    rtt_shell_puts(command->name);
+    rtt_shell_puts(" ");
+    rtt_shell_puts(command->usage);
+    rtt_shell_puts("\n");
+}
+
+static int rtt_shell_help(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    for (unsigned i = 0; i < RTT_SHELL_BUILTINS; i++) rtt_shell_put_usage(&rtt_shell_builtins[i]);
+    for (unsigned i = 0; i < rtt_shell.count; i++) rtt_shell_put_usage(&rtt_shell.commands[i]);
+
+    return 0;
+}
+
+static const rtt_shell_command_t *rtt_shell_find(const char *name)
+{
+    for (unsigned i = 0; i < RTT_SHELL_BUILTINS; i++) {
+        if (rtt_shell_streq(name, rtt_shell_builtins[i].name)) return &rtt_shell_builtins[i];
+    }
+
+    for (unsigned i = 0; i < rtt_shell.count; i++) {
+        if (rtt_shell_streq(name, rtt_shell.commands[i].name)) return &rtt_shell.commands[i];
+    }
+
+    return 0;
+}
+
+/** Split the line into arguments in place and run the command.
+ */
+static void rtt_shell_execute(char *line)
+{
+    char *argv[RTT_SHELL_MAX_ARGS];
+    int argc = 0;
+
+    while (*line) {
+        while (*line == ' ' || *line == '\t') *line++ = 0;
+
+        if (*line == 0) break;
+
+        if (argc == RTT_SHELL_MAX_ARGS) {
+            rtt_shell_puts("too many arguments\n");
+            return;
+        }
+
+        argv[argc++] = line;
+
+        while (*line && *line != ' ' && *line != '\t') line++;
+    }
+
+    if (argc == 0) return;
+
+    const rtt_shell_command_t *command = rtt_shell_find(argv[0]);
+
+    if (command == 0) {
+        rtt_shell_puts("unknown command, try help\n");
+    } else if (command->func(argc, argv) != 0) {
+        rtt_shell_puts("usage: ");
+        rtt_shell_put_usage(command);
+    }
+}
+
+void rtt_shell_init(const rtt_shell_command_t *commands, unsigned count)
+{
+    rtt_shell.commands = commands;
+    rtt_shell.count = count;
+    rtt_shell.length = 0;
+    rtt_shell.overflow = false;
+
+    rtt_shell_puts(RTT_SHELL_PROMPT);
+}
+
+void rtt_shell_poll(void)
+{
+    char input[16];
+    unsigned size;
+
+    while ((size = SEGGER_RTT_Read(0, input, sizeof(input))) != 0) {
+        for (unsigned i = 0; i < size; i++) {
+            char c = input[i];
+
+            if (c == '\r' || c == '\n') {
+                // "\r\n" from the host gives an empty second line, which is ignored
+                if (rtt_shell.length == 0 && !rtt_shell.overflow) continue;
+
+                if (rtt_shell.overflow) {
+                    rtt_shell_puts("line too long\n");
+                } else {
+                    rtt_shell.line[rtt_shell.length] = 0;
+                    rtt_shell_execute(rtt_shell.line);
+                }
+
+                rtt_shell.length = 0;
+                rtt_shell.overflow = false;
+                rtt_shell_puts(RTT_SHELL_PROMPT);
+            } else if (c == '\b' || c == 0x7F) {
+                if (rtt_shell.length) rtt_shell.length--;
+            } else if (rtt_shell.length < RTT_SHELL_LINE_SIZE - 1) {
+                rtt_shell.line[rtt_shell.length++] = c;
+            } else {
+                rtt_shell.overflow = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef RTT_SHELL_H
+#define RTT_SHELL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Command shell on the RTT terminal down-channel.
+ *
+ * rtt_shell_poll() is non-blocking: it takes what the host has sent with
+ * SEGGER_RTT_Read(), collects a line and runs the command when the line is
+ * complete. Call it from the main loop or an idle hook, never from an
+ * interrupt handler. The line is split into arguments in place, nothing is
+ * allocated and nothing is formatted with printf.
+ *
+ * Built-in commands: help, peek, poke, rtt. The application adds its own
+ * commands with a const table passed to rtt_shell_init().
+ */
+
+#ifndef RTT_SHELL_LINE_SIZE
+#define RTT_SHELL_LINE_SIZE  64
+#endif
+
+#ifndef RTT_SHELL_PEEK_MAX
+#define RTT_SHELL_PEEK_MAX   256    // Words per peek command
+#endif
+
+#ifndef RTT_SHELL_MAX_ARGS
+#define RTT_SHELL_MAX_ARGS   6
+#endif
+
+/** Command handler, argv[0] is the command name.
+ * @return 0 on success, otherwise the usage line is printed.
+ */
+typedef int rtt_shell_func_t(int argc, char *argv[]);
+
+typedef struct {
+    const char *name;
+    const char *usage;    // Arguments and a short description for help
+    rtt_shell_func_t *func;
+} rtt_shell_command_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Install the application command table and print the prompt.
+ */
+void rtt_shell_init(const rtt_shell_command_t *commands, unsigned count);
+
+/** Read pending input and run a completed command line.
+ */
+void rtt_shell_poll(void);
+
+/** Output helpers for command handlers, written to the terminal channel.
+ */
+void rtt_shell_puts(const char *s);
+void rtt_shell_put_dec(uint32_t value);
+void rtt_shell_put_hex(uint32_t value);
+
+/** Parse a decimal or 0x-prefixed hexadecimal number, false on a bad digit or overflow.
+ */
+bool rtt_shell_parse_u32(const char *s, uint32_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTT_SHELL_H
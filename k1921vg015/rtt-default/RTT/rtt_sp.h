@@ -0,0 +1,54 @@
+#ifndef RTT_SP_H
+#define RTT_SP_H
+
+#include "SEGGER_RTT.h"
+#include "rtt_channel.h"
+#include "rtt_memcpy.h"
+
+/** Lock-free write path for up-channels with exactly one producer context.
+ *
+ * An up-buffer is a single-producer/single-consumer ring: the target only
+ * writes WrOff, the debug probe only writes RdOff. While one context (the main
+ * loop or one interrupt handler) is the only writer of a channel, no lock is
+ * needed, the data just has to be stored before WrOff (RTT__DMB()).
+ *
+ * Channel 0 is shared by printf and the terminal, keep using the locked
+ * SEGGER_RTT_Write() for it. The control block must be initialized
+ * (SEGGER_RTT_Init() or any locked RTT call) before the first rtt_sp_write().
+ */
+
+/** Store the whole message or nothing (skip mode).
+ * @return 1 if the message was stored, 0 if the ring is full.
+ */
+static inline unsigned rtt_sp_write(unsigned channel, const void *data, unsigned size) {
+    SEGGER_RTT_BUFFER_UP *ring = &_SEGGER_RTT.aUp[channel];
+    unsigned rd = ring->RdOff;
+    unsigned wr = ring->WrOff;
+    unsigned ring_size = ring->SizeOfBuffer;
+    // One byte stays free to tell a full ring from an empty one
+    unsigned avail = (rd > wr ? rd : rd + ring_size) - wr - 1;
+
+    if (size > avail) {
+        rtt_channel_account(channel, 0, size);
+        return 0;
+    }
+
+    unsigned tail = ring_size - wr;
+
+    if (size < tail) {
+        rtt_memcpy(ring->pBuffer + wr, data, size);
+        wr += size;
+    } else {
+        rtt_memcpy(ring->pBuffer + wr, data, tail);
+        rtt_memcpy(ring->pBuffer, (const char *)data + tail, size - tail);
+        wr = size - tail;
+    }
+
+    RTT__DMB();
+    ring->WrOff = wr;
+    rtt_channel_account(channel, size, size);
+
+    return 1;
+}
+
+#endif // RTT_SP_H
@@ -0,0 +1,26 @@
+#include "rtt_trace.h"
+#include "rtt_sp.h"
+
+#if RTT_TRACE_CHANNEL >= SEGGER_RTT_MAX_NUM_UP_BUFFERS
+#error "RTT_TRACE_CHANNEL exceeds SEGGER_RTT_MAX_NUM_UP_BUFFERS"
+#endif
+
+static unsigned rtt_trace_output(const void *data, unsigned size)
+{
+    return rtt_sp_write(RTT_TRACE_CHANNEL, data, size);
+}
+
+void rtt_trace_init(void)
+{
+    rtt_channel_setup(RTT_TRACE_CHANNEL, "Trace", RTT_TRACE_BUFFER_SIZE, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+void rtt_trace_start(void)
+{
+    trace_start(rtt_trace_output);
+}
+
+void rtt_trace_stop(void)
+{
+    trace_stop();
+}
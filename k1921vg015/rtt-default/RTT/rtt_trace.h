@@ -0,0 +1,44 @@
+#ifndef RTT_TRACE_H
+#define RTT_TRACE_H
+
+#include "rtt_channel.h"
+#include "trace.h"
+
+/** RTT output of the binary event trace (trace.h).
+ *
+ * Events go to their own up-channel in skip mode: an event that does not fit
+ * is dropped whole and counted by trace.c. trace_emit() masks interrupts, so
+ * the channel has a single producer at any time and is written with
+ * rtt_sp_write(). Capture the channel to a file (e.g. JLinkRTTLogger
+ * -RTTChannel 4) and convert it with tools/rtt_trace.py.
+ */
+
+#ifndef RTT_TRACE_CHANNEL
+#define RTT_TRACE_CHANNEL      RTT_CHANNEL_TRACE
+#endif
+
+#ifndef RTT_TRACE_BUFFER_SIZE
+#define RTT_TRACE_BUFFER_SIZE  4096
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Configure the trace up-channel, the buffer is taken from the channel pool.
+ */
+void rtt_trace_init(void);
+
+/** Start tracing to the channel.
+ */
+void rtt_trace_start(void);
+
+/** Stop tracing.
+ */
+void rtt_trace_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTT_TRACE_H
@@ -74,12 +74,15 @@ Revision: $Rev: 13430 $
 **********************************************************************
 */
 
-// Most common case:
-// Up-channel 0: RTT
-// Up-channel 1: SystemView
+// Up-channel 0: Terminal
+// Up-channel 1: Bench (RTT benchmarks)
+// Up-channel 2: Log (deferred binary log)
+// Up-channel 3: Prof (PC samples of the profiler)
+// Up-channel 4: Trace (binary event trace)
+// See RTT/rtt_channel.h
 //
 #ifndef   SEGGER_RTT_MAX_NUM_UP_BUFFERS
-  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (1)     // Max. number of up-buffers (T->H) available on this target    (Default: 3)
+  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (5)     // Max. number of up-buffers (T->H) available on this target    (Default: 3)
 #endif
 //
 // Most common case:
@@ -91,11 +94,18 @@ Revision: $Rev: 13430 $
 #endif
 
 #ifndef   BUFFER_SIZE_UP
-  #define BUFFER_SIZE_UP                            (512u)  // Size of the buffer for terminal output of target, up to host (Default: 1k)
+  #define BUFFER_SIZE_UP                            (2048u) // Size of the buffer for terminal output of target, up to host (Default: 1k)
+#endif
+
+//
+// Terminal buffers live in RAM1 next to the channel pool of RTT/rtt_channel.c (not cleared at startup).
+//
+#ifndef   SEGGER_RTT_BUFFER_SECTION
+  #define SEGGER_RTT_BUFFER_SECTION                 ".ram1.bss.rtt"
 #endif
 
 #ifndef   BUFFER_SIZE_DOWN
-  #define BUFFER_SIZE_DOWN                          (16u)   // Size of the buffer for terminal input to target from host (Usually keyboard input) (Default: 16)
+  #define BUFFER_SIZE_DOWN                          (128u)  // Size of the buffer for terminal input to target from host (Usually keyboard input, RTT/rtt_shell.c) (Default: 16)
 #endif
 
 #ifndef   SEGGER_RTT_PRINTF_BUFFER_SIZE
@@ -125,6 +135,13 @@ Revision: $Rev: 13430 $
 //#if ((defined __SES_ARM) || (defined __CROSSWORKS_ARM) || (defined __GNUC__)) && (defined (__ARM_ARCH_7A__))  
 //  #define SEGGER_RTT_MEMCPY(pDest, pSrc, NumBytes)      SEGGER_memcpy((pDest), (pSrc), (NumBytes))
 //#endif
+//
+// RISC-V: word-wide copy, memcpy() is never inlined with -fno-builtin and copies bytewise with -mstrict-align (RTT/rtt_memcpy.c)
+//
+#if defined(__riscv)
+  #include "rtt_memcpy.h"
+  #define SEGGER_RTT_MEMCPY(pDest, pSrc, NumBytes)      rtt_memcpy((pDest), (pSrc), (NumBytes))
+#endif
 
 //
 // Target is not allowed to perform other RTT operations while string still has not been stored completely.
@@ -210,6 +227,26 @@ Revision: $Rev: 13430 $
                                                 : "r0", "r1"                   \
                                                 );                             \
                             }
+  #elif defined(__riscv)
+    //
+    // RISC-V: mask machine interrupts via mstatus.MIE and restore the previous state,
+    // so the lock is nestable and may be taken from within a trap handler.
+    // The CSR helpers have no memory clobber, the empty asm keeps the ring accesses inside the lock.
+    //
+    #include "riscv-csr.h"
+
+    #define SEGGER_RTT_LOCK()   {                                                                   \
+                                  uint_xlen_t LockState;                                            \
+                                  LockState = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);      \
+                                  __asm volatile ("" : : : "memory");
+
+    #define SEGGER_RTT_UNLOCK()   __asm volatile ("" : : : "memory");                               \
+                                  csr_set_bits_mstatus(LockState & MSTATUS_MIE_BIT_MASK);           \
+                                }
+    //
+    // The debug probe reads the ring through the system bus: the data must be visible before <WrOff>.
+    //
+    #define RTT__DMB()          __asm volatile ("fence rw, w" : : : "memory")
 #else
     #define SEGGER_RTT_LOCK()
     #define SEGGER_RTT_UNLOCK()
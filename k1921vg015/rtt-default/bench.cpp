@@ -0,0 +1,1152 @@
+#include <K1921VG015.h>
+#include <system_k1921vg015.h>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+extern "C" {
+#include <mtimer.h>
+#include <swtimer.h>
+#include <riscv-csr.h>
+#include <riscv-irq.h>
+#include <irq_stats.h>
+#include <mem_stats.h>
+#include <flash_timing.h>
+#include <perf.h>
+}
+#include "SEGGER_RTT.h"
+#include "rtt_channel.h"
+#include "rtt_sp.h"
+#include "rtt_memcpy.h"
+#include "rtt_log.h"
+#include "rtt_prof.h"
+#include "rtt_trace.h"
+#include "format.h"
+#include "shell.h"
+#include "bench.h"
+
+// SEGGER RTT: IP: localhost, PORT: 19021.
+#define print(s)                        rtt_channel_write( RTT_CHANNEL_TERMINAL, s, sizeof( s ) - 1 ); sleep(1)
+#define println(s)                      print( s "\n" )
+#define printf( format, ... )           SEGGER_RTT_printf( 0, ( const char * ) ( format ), ##__VA_ARGS__ ); sleep(1)
+
+/**
+ * @brief   Переводит такты mtime в наносекунды.
+ *
+ */
+static unsigned int MtimeToNs( uint64_t clocks )
+{
+    return ( unsigned int ) ( clocks * 1000000000ULL / MTIME_FREQ_HZ );
+}
+
+/**
+ * @brief   Измеряет задержку пробуждения и джиттер sleep()/usleep().
+ *
+ */
+void SleepLatencyTest()
+{
+    static const uint32_t Delays[] = { 1, 10, 100, 1000 }; // мкс
+
+    println( "###### Testing usleep() wake-up latency ######" );
+
+    for ( uint32_t Delay : Delays )
+    {
+        mtimer_sleep_stats_reset();
+
+        for ( int i = 0; i < 100; i++ ) usleep( Delay );
+
+        // Копия, т.к. printf() сам вызывает sleep().
+        mtimer_sleep_stats_t Stats = const_cast<const mtimer_sleep_stats_t &>( mtimer_sleep_stats );
+
+        printf( "usleep(%4u): latency min %u ns, avg %u ns, max %u ns, jitter %u ns, wakeups %u.\n",
+                ( unsigned int ) Delay,
+                MtimeToNs( Stats.min_latency ),
+                MtimeToNs( Stats.sum_latency / Stats.count ),
+                MtimeToNs( Stats.max_latency ),
+                MtimeToNs( Stats.max_latency - Stats.min_latency ),
+                ( unsigned int ) Stats.wakeups );
+    }
+
+    println( "###### usleep() Tests done. ######" );
+}
+
+static volatile uint64_t ProbeCompare;
+static volatile uint32_t ProbeLatency;
+
+static volatile uint32_t ProbeCycle;
+
+static void IrqLatencyProbe()
+{
+    ProbeLatency = ( uint32_t ) ( mtimer_get_raw_time() - ProbeCompare );
+
+    mtimer_set_raw_time_cmp_abs( UINT64_MAX );
+}
+
+static void IrqCycleProbe()
+{
+    ProbeCycle = ( uint32_t ) csr_read_mcycle();
+
+    mtimer_set_raw_time_cmp_abs( UINT64_MAX );
+}
+
+/**
+ * @brief   Такты mcycle от инструкции, разрешившей прерывание, до обработчика: MTIP выставлен
+ *          заранее, поэтому ловушка берется сразу после установки MIE. В результат входят
+ *          аппаратный вход в ловушку, trap_entry, trap_handler() и вызов обработчика.
+ *
+ */
+static void IrqEntryCycles( uint32_t Count )
+{
+    uint32_t Min = UINT32_MAX, Max = 0, Sum = 0;
+
+    riscv_handler_map[RISCV_IRQ_MTI] = IrqCycleProbe;
+
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        csr_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+        mtimer_set_raw_time_cmp_abs( 0 );
+
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();
+        csr_set_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+        // ProbeCycle записан обработчиком: чтение не должно подняться выше установки MIE
+        __asm__ volatile( "" ::: "memory" );
+        uint32_t Cycles = ProbeCycle - Start;
+
+        if ( Cycles < Min ) Min = Cycles;
+        if ( Cycles > Max ) Max = Cycles;
+        Sum += Cycles;
+    }
+
+    printf( "IRQ entry (PLF_TRAP_FAST_IRQ=%d): MIE set to handler min %u, avg %u, max %u mcycle.\n",
+            PLF_TRAP_FAST_IRQ,
+            ( unsigned int ) Min,
+            ( unsigned int ) ( Sum / Count ),
+            ( unsigned int ) Max );
+}
+
+/**
+ * @brief   Измеряет задержку входа в обработчик прерывания (от срабатывания mtimecmp до обработчика).
+ *
+ */
+void IrqLatencyTest()
+{
+    uint32_t Min = UINT32_MAX, Max = 0, Sum = 0;
+    const uint32_t Count = 100;
+
+    println( "###### Testing interrupt entry latency ######" );
+
+    // Временно забираем mtimecmp и обработчик MTI у swtimer.
+    uint_xlen_t Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+    uint64_t Compare = mtimer_get_raw_time_cmp();
+    irqfunc_t *Handler = riscv_handler_map[RISCV_IRQ_MTI];
+
+    riscv_handler_map[RISCV_IRQ_MTI] = IrqLatencyProbe;
+    csr_write_mstatus( Mstatus );
+
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        ProbeLatency = UINT32_MAX;
+        ProbeCompare = mtimer_get_raw_time() + MTIMER_USEC_TO_CLOCKS( 10 );
+        mtimer_set_raw_time_cmp_abs( ProbeCompare );
+
+        while ( ProbeLatency == UINT32_MAX );
+
+        if ( ProbeLatency < Min ) Min = ProbeLatency;
+        if ( ProbeLatency > Max ) Max = ProbeLatency;
+        Sum += ProbeLatency;
+    }
+
+    IrqEntryCycles( Count );
+
+    Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+    riscv_handler_map[RISCV_IRQ_MTI] = Handler;
+    mtimer_set_raw_time_cmp_abs( Compare );
+    csr_write_mstatus( Mstatus );
+
+    // Такты mtime в такты ядра.
+    const uint32_t Ratio = SystemCoreClock / MTIME_FREQ_HZ;
+
+    printf( "IRQ entry (PLF_TRAP_FAST_IRQ=%d): latency min %u, avg %u, max %u cycles.\n",
+            PLF_TRAP_FAST_IRQ,
+            ( unsigned int ) ( Min * Ratio ),
+            ( unsigned int ) ( Sum / Count * Ratio ),
+            ( unsigned int ) ( Max * Ratio ) );
+
+    println( "###### IRQ Tests done. ######" );
+}
+
+static volatile uint32_t HotSeed = 1;
+static volatile uint32_t HotResult;
+static volatile uint32_t HotCycles;
+
+// 512 шагов без ветвлений (~3 КБ кода): больше кэша флеш, каждый вызов идёт по новым строкам.
+#define HOT_X8( S ) S S S S S S S S
+#define HOT_BODY( Acc ) HOT_X8( HOT_X8( HOT_X8( Acc = ( Acc ^ ( Acc >> 7 ) ) * 0x9E3779B1u; ) ) )
+
+// Обработчик MTI с телом HOT_BODY; время считается от входа в обработчик, диспетчер не входит.
+#define HOT_ISR( Name, Attr )                                       \
+    Attr static void Name()                                         \
+    {                                                               \
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();            \
+        uint32_t Acc = HotSeed;                                     \
+        HOT_BODY( Acc );                                            \
+        HotResult = Acc;                                            \
+        HotCycles = ( uint32_t ) csr_read_mcycle() - Start;         \
+        mtimer_set_raw_time_cmp_abs( UINT64_MAX );                  \
+    }
+
+HOT_ISR( HotIsrFlash, __attribute__( ( noinline ) ) )
+HOT_ISR( HotIsrRam, __ramfunc )
+
+/**
+ * @brief   Вызывает обработчик Isr через прерывание MTI, возвращает среднее время в тактах.
+ *
+ * @param   Isr     Обработчик.
+ * @param   Flush   Сбрасывать кэш флеш перед каждым прерыванием.
+ */
+static uint32_t HotIsrRun( irqfunc_t *Isr, bool Flush )
+{
+    const uint32_t Count = 32;
+    uint32_t Sum = 0;
+
+    // Временно забираем mtimecmp и обработчик MTI у swtimer.
+    uint_xlen_t Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+    uint64_t Compare = mtimer_get_raw_time_cmp();
+    irqfunc_t *Handler = riscv_handler_map[RISCV_IRQ_MTI];
+
+    riscv_handler_map[RISCV_IRQ_MTI] = Isr;
+    csr_write_mstatus( Mstatus );
+
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        if ( Flush ) flash_cache_flush();
+
+        HotCycles = UINT32_MAX;
+        mtimer_set_raw_time_cmp_abs( mtimer_get_raw_time() );
+
+        while ( HotCycles == UINT32_MAX );
+
+        Sum += HotCycles;
+    }
+
+    Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+    riscv_handler_map[RISCV_IRQ_MTI] = Handler;
+    mtimer_set_raw_time_cmp_abs( Compare );
+    csr_write_mstatus( Mstatus );
+
+    return Sum / Count;
+}
+
+/**
+ * @brief   Сравнивает обработчик прерывания из флеш (с холодным и прогретым кэшем) и из RAM (__ramfunc).
+ *
+ */
+void RamFuncBenchmark()
+{
+    println( "###### Testing __ramfunc ISR ######" );
+
+    printf( "ISR from flash, cache flushed: %u cycles.\n", ( unsigned int ) HotIsrRun( HotIsrFlash, true ) );
+    printf( "ISR from flash, cache warm:    %u cycles.\n", ( unsigned int ) HotIsrRun( HotIsrFlash, false ) );
+    printf( "ISR from RAM (0x%08X):  %u cycles.\n",
+            ( unsigned int ) ( uintptr_t ) HotIsrRam,
+            ( unsigned int ) HotIsrRun( HotIsrRam, true ) );
+
+    println( "###### __ramfunc Tests done. ######" );
+}
+
+// Нагрузка в духе CoreMark: связный список, умножение матриц, конечный автомат и CRC16 результатов.
+struct MarkNode
+{
+    MarkNode *Next;
+    int16_t Value;
+};
+
+static MarkNode MarkNodes[32];
+static int16_t MarkMatA[8][8], MarkMatB[8][8];
+static int32_t MarkMatC[8][8];
+static const char MarkInput[] = "5012,-17.25,+3e4,abc,0x1F,77,-0.5,9e-2,1.e,+,314159,";
+static volatile int16_t MarkSeed = 7;
+
+static uint16_t MarkCrc16( uint16_t Crc, uint16_t Data )
+{
+    for ( uint32_t Bit = 0; Bit < 16; Bit++ )
+    {
+        uint16_t Carry = ( Crc ^ Data ) & 1;
+
+        Data >>= 1;
+        Crc = ( Crc >> 1 ) ^ ( Carry ? 0xA001 : 0 );
+    }
+
+    return Crc;
+}
+
+/**
+ * @brief   Строит список, разворачивает его и суммирует нечётные значения.
+ *
+ */
+static uint16_t MarkList( int16_t Seed )
+{
+    MarkNode *Head = nullptr;
+
+    for ( uint32_t i = 0; i < sizeof( MarkNodes ) / sizeof( MarkNodes[0] ); i++ )
+    {
+        MarkNodes[i].Value = ( int16_t ) ( ( i * 37 + Seed ) & 0xFF );
+        MarkNodes[i].Next = Head;
+        Head = &MarkNodes[i];
+    }
+
+    MarkNode *Reversed = nullptr;
+
+    while ( Head )
+    {
+        MarkNode *Next = Head->Next;
+
+        Head->Next = Reversed;
+        Reversed = Head;
+        Head = Next;
+    }
+
+    uint16_t Sum = 0;
+
+    for ( MarkNode *Node = Reversed; Node; Node = Node->Next )
+    {
+        if ( Node->Value & 1 ) Sum += Node->Value;
+    }
+
+    return Sum;
+}
+
+/**
+ * @brief   Умножает матрицы 8x8 и возвращает CRC16 сумм строк.
+ *
+ */
+static uint16_t MarkMatrix( int16_t Seed )
+{
+    uint16_t Crc = 0;
+
+    for ( uint32_t i = 0; i < 8; i++ )
+    {
+        for ( uint32_t j = 0; j < 8; j++ )
+        {
+            MarkMatA[i][j] = ( int16_t ) ( i * 8 + j + Seed );
+            MarkMatB[i][j] = ( int16_t ) ( j * 8 - i - Seed );
+        }
+    }
+
+    for ( uint32_t i = 0; i < 8; i++ )
+    {
+        int32_t Row = 0;
+
+        for ( uint32_t j = 0; j < 8; j++ )
+        {
+            int32_t Acc = 0;
+
+            for ( uint32_t k = 0; k < 8; k++ ) Acc += MarkMatA[i][k] * MarkMatB[k][j];
+
+            MarkMatC[i][j] = Acc;
+            Row += Acc;
+        }
+
+        Crc = MarkCrc16( Crc, ( uint16_t ) Row );
+    }
+
+    return Crc;
+}
+
+/**
+ * @brief   Разбирает числа из MarkInput конечным автоматом, возвращает CRC16 счётчиков состояний.
+ *
+ */
+static uint16_t MarkStates()
+{
+    enum { Start, Sign, Int, Frac, Exp, ExpSign, ExpInt, Invalid, Count };
+
+    uint16_t Hits[Count] = {};
+    uint32_t State = Start;
+
+    for ( const char *p = MarkInput; *p; p++ )
+    {
+        char c = *p;
+
+        if ( c == ',' )
+        {
+            Hits[State]++;
+            State = Start;
+            continue;
+        }
+
+        bool Digit = c >= '0' && c <= '9';
+
+        switch ( State )
+        {
+            case Start:   State = Digit ? Int : ( c == '+' || c == '-' ) ? Sign : c == '.' ? Frac : Invalid; break;
+            case Sign:    State = Digit ? Int : c == '.' ? Frac : Invalid; break;
+            case Int:     State = Digit ? Int : c == '.' ? Frac : ( c == 'e' || c == 'E' ) ? Exp : Invalid; break;
+            case Frac:    State = Digit ? Frac : ( c == 'e' || c == 'E' ) ? Exp : Invalid; break;
+            case Exp:     State = Digit ? ExpInt : ( c == '+' || c == '-' ) ? ExpSign : Invalid; break;
+            case ExpSign: State = Digit ? ExpInt : Invalid; break;
+            case ExpInt:  State = Digit ? ExpInt : Invalid; break;
+            default:      break;
+        }
+    }
+
+    uint16_t Crc = 0;
+
+    for ( uint16_t Hit : Hits ) Crc = MarkCrc16( Crc, Hit );
+
+    return Crc;
+}
+
+/**
+ * @brief   Сравнивает производительность при разных задержках флеш (LAT) с кэшем и без.
+ *
+ */
+void FlashLatencyBenchmark()
+{
+    const uint32_t Iterations = 50;
+    const uint32_t Saved = flash_latency_get();
+    const uint32_t Min = flash_latency_for( SystemCoreClock );
+
+    println( "###### Testing flash latency ######" );
+
+    printf( "SYSCLK %u Hz, minimum LAT %u (access %u ns), current LAT %u.\n",
+            ( unsigned int ) SystemCoreClock,
+            ( unsigned int ) Min,
+            ( unsigned int ) FLASH_ACCESS_NS,
+            ( unsigned int ) Saved );
+
+    for ( uint32_t Lat = Min; Lat <= Min + 4 && Lat <= FLASH_LAT_MAX; Lat++ )
+    {
+        flash_latency_set( Lat );
+
+        for ( int Cache = 1; Cache >= 0; Cache-- )
+        {
+            uint16_t Crc = 0;
+
+            flash_cache_enable( Cache );
+            flash_cache_flush();
+
+            uint_xlen_t Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+            uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+            for ( uint32_t i = 0; i < Iterations; i++ )
+            {
+                int16_t Seed = ( int16_t ) ( MarkSeed + i );
+
+                Crc = MarkCrc16( Crc, MarkList( Seed ) );
+                Crc = MarkCrc16( Crc, MarkMatrix( Seed ) );
+                Crc = MarkCrc16( Crc, MarkStates() );
+            }
+
+            uint32_t Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+
+            csr_write_mstatus( Mstatus );
+
+            printf( "LAT %2u, cache %s: %u cycles/iteration, %u iterations/s (crc 0x%04X).\n",
+                    ( unsigned int ) Lat,
+                    Cache ? "on " : "off",
+                    ( unsigned int ) ( Cycles / Iterations ),
+                    ( unsigned int ) ( ( uint64_t ) SystemCoreClock * Iterations / Cycles ),
+                    ( unsigned int ) Crc );
+        }
+    }
+
+    flash_latency_set( Saved );
+    flash_cache_enable( 1 );
+
+    println( "###### Flash latency Tests done. ######" );
+}
+
+static volatile uint32_t PerfNotified[2];
+
+static void PerfNotifierCount( perf_notifier_t *, perf_event_t Event, uint32_t )
+{
+    PerfNotified[Event]++;
+}
+
+/**
+ * @brief   Замеряет переключение уровней производительности и скорость на каждом уровне.
+ *
+ */
+void PerfSwitchBenchmark()
+{
+    static const perf_level_t Sequence[] = { PERF_LEVEL_MID, PERF_LEVEL_LOW, PERF_LEVEL_HIGH, PERF_LEVEL_LOW, PERF_LEVEL_MID, PERF_LEVEL_HIGH };
+    const uint32_t Iterations = 20;
+    const perf_level_t Saved = perf_get_level();
+    perf_notifier_t Notifier;
+
+    println( "###### Testing performance levels ######" );
+
+    PerfNotified[0] = PerfNotified[1] = 0;
+    perf_notifier_register( &Notifier, PerfNotifierCount, nullptr );
+
+    for ( perf_level_t Level : Sequence )
+    {
+        const char *From = PerfLevelNames[perf_get_level()];
+        int Status = perf_set_level( Level );
+        perf_stats_t Stats = const_cast<const perf_stats_t &>( perf_stats );
+        uint16_t Crc = 0;
+
+        uint_xlen_t Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+        for ( uint32_t i = 0; i < Iterations; i++ )
+        {
+            Crc = MarkCrc16( Crc, MarkList( ( int16_t ) ( MarkSeed + i ) ) );
+        }
+
+        uint32_t Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+
+        csr_write_mstatus( Mstatus );
+
+        printf( "%-4s -> %-4s: %s, SYSCLK %u Hz, LAT %u, switch %u ns (%u cycles), %u us/iteration (crc 0x%04X).\n",
+                From,
+                PerfLevelNames[Level],
+                Status ? "failed" : "ok",
+                ( unsigned int ) SystemCoreClock,
+                ( unsigned int ) flash_latency_get(),
+                ( unsigned int ) Stats.last_ns,
+                ( unsigned int ) Stats.last_cycles,
+                ( unsigned int ) ( ( uint64_t ) Cycles * 1000000 / Iterations / SystemCoreClock ),
+                ( unsigned int ) Crc );
+    }
+
+    perf_notifier_unregister( &Notifier );
+    perf_set_level( Saved );
+
+    printf( "Notifier calls: pre %u, post %u; max switch %u ns, failed %u.\n",
+            ( unsigned int ) PerfNotified[PERF_PRE_CHANGE],
+            ( unsigned int ) PerfNotified[PERF_POST_CHANGE],
+            ( unsigned int ) perf_stats.max_ns,
+            ( unsigned int ) perf_stats.failed );
+
+    println( "###### Performance level Tests done. ######" );
+}
+
+static swtimer_t BenchTimers[2000];
+static volatile uint32_t BenchExpired;
+
+static void BenchTimerCallback( swtimer_t *, void * )
+{
+    BenchExpired++;
+}
+
+/**
+ * @brief   Измеряет стоимость запуска, остановки и срабатывания программных таймеров.
+ *
+ */
+void SwTimerBenchmark()
+{
+    const uint32_t Count = sizeof( BenchTimers ) / sizeof( BenchTimers[0] );
+    uint32_t Seed = 1;
+
+    println( "###### Testing swtimer ######" );
+
+    for ( swtimer_t &Timer : BenchTimers ) swtimer_setup( &Timer, BenchTimerCallback, NULL );
+
+    BenchExpired = 0;
+    swtimer_stats_reset();
+
+    // Задержки от 10 мс до ~95 мс, чтобы задействовать несколько уровней колеса.
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+    for ( swtimer_t &Timer : BenchTimers )
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        swtimer_start( &Timer, SWTIMER_MSEC_TO_TICKS( 10 ) + ( Seed >> 20 ), 0 );
+    }
+
+    uint32_t StartCycles = ( uint32_t ) csr_read_mcycle() - Start;
+
+    // Останавливаем и перезапускаем каждый второй таймер.
+    Start = ( uint32_t ) csr_read_mcycle();
+
+    for ( uint32_t i = 0; i < Count; i += 2 ) swtimer_stop( &BenchTimers[i] );
+
+    uint32_t StopCycles = ( uint32_t ) csr_read_mcycle() - Start;
+
+    for ( uint32_t i = 0; i < Count; i += 2 ) swtimer_start( &BenchTimers[i], SWTIMER_MSEC_TO_TICKS( 300 ), 0 );
+
+    while ( BenchExpired < Count ) sleep( 10 );
+
+    // Копия, т.к. printf() сам вызывает sleep().
+    swtimer_stats_t Stats = const_cast<const swtimer_stats_t &>( swtimer_stats );
+
+    printf( "swtimer: %u timers, start %u cycles, stop %u cycles.\n",
+            ( unsigned int ) Count,
+            ( unsigned int ) ( StartCycles / Count ),
+            ( unsigned int ) ( StopCycles / ( Count / 2 ) ) );
+
+    printf( "swtimer: %u expired in %u dispatches, %u cascaded, %u cycles per timer, max dispatch %u cycles.\n",
+            ( unsigned int ) Stats.expired,
+            ( unsigned int ) Stats.dispatches,
+            ( unsigned int ) Stats.cascaded,
+            ( unsigned int ) ( Stats.sum_cycles / Stats.expired ),
+            ( unsigned int ) Stats.max_cycles );
+
+    println( "###### swtimer Tests done. ######" );
+}
+
+/**
+ * @brief   Очищает канал замеров перед проходом (хост этот канал обычно не читает).
+ *
+ */
+static void RttBenchReset()
+{
+    _SEGGER_RTT.aUp[RTT_CHANNEL_BENCH].WrOff = _SEGGER_RTT.aUp[RTT_CHANNEL_BENCH].RdOff;
+}
+
+/**
+ * @brief   Сравнивает стоимость записи в RTT: без блокировки, с блокировкой по mstatus.MIE
+ *          и через lock-free путь для одного производителя.
+ *
+ */
+void RttWriteBenchmark()
+{
+    static const char Message[16] = "RTT bench 0123";
+    const uint32_t Rounds = 32;
+    // 32 сообщения по 16 байт помещаются в буфер целиком, поэтому ни одна запись не пропускается.
+    const uint32_t Writes = 32;
+    uint32_t Unlocked = 0, Locked = 0, LockFree = 0;
+
+    println( "###### Testing RTT write paths ######" );
+
+    for ( uint32_t Round = 0; Round < Rounds; Round++ )
+    {
+        RttBenchReset();
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+        for ( uint32_t i = 0; i < Writes; i++ ) SEGGER_RTT_WriteNoLock( RTT_CHANNEL_BENCH, Message, sizeof( Message ) );
+
+        Unlocked += ( uint32_t ) csr_read_mcycle() - Start;
+
+        RttBenchReset();
+        Start = ( uint32_t ) csr_read_mcycle();
+
+        for ( uint32_t i = 0; i < Writes; i++ ) SEGGER_RTT_Write( RTT_CHANNEL_BENCH, Message, sizeof( Message ) );
+
+        Locked += ( uint32_t ) csr_read_mcycle() - Start;
+
+        RttBenchReset();
+        Start = ( uint32_t ) csr_read_mcycle();
+
+        for ( uint32_t i = 0; i < Writes; i++ ) rtt_sp_write( RTT_CHANNEL_BENCH, Message, sizeof( Message ) );
+
+        LockFree += ( uint32_t ) csr_read_mcycle() - Start;
+    }
+
+    printf( "RTT write of %u bytes: unlocked %u, locked %u, lock-free %u cycles.\n",
+            ( unsigned int ) sizeof( Message ),
+            ( unsigned int ) ( Unlocked / ( Rounds * Writes ) ),
+            ( unsigned int ) ( Locked / ( Rounds * Writes ) ),
+            ( unsigned int ) ( LockFree / ( Rounds * Writes ) ) );
+
+    println( "###### RTT write Tests done. ######" );
+}
+
+static uint32_t CopySource[1024 / 4 + 1];
+static uint32_t CopyTarget[1024 / 4];
+
+/**
+ * @brief   Измеряет SEGGER_RTT_Write() и копирование в кольцо на блоках 16, 64, 256 и 1024 байт.
+ *          Прерывания запрещены, берётся минимум из нескольких прогонов.
+ *
+ */
+void RttCopyBenchmark()
+{
+    static const uint32_t Sizes[] = { 16, 64, 256, 1024 };
+    const uint32_t Runs = 8;
+
+    println( "###### Testing RTT copy ######" );
+
+    for ( uint32_t Size : Sizes )
+    {
+        uint32_t Write = UINT32_MAX, Word = UINT32_MAX, Misaligned = UINT32_MAX, Libc = UINT32_MAX;
+
+        for ( uint32_t Run = 0; Run < Runs; Run++ )
+        {
+            uint_xlen_t Mstatus = csr_read_clr_bits_mstatus( MSTATUS_MIE_BIT_MASK );
+
+            RttBenchReset();
+            uint32_t Start = ( uint32_t ) csr_read_mcycle();
+            SEGGER_RTT_Write( RTT_CHANNEL_BENCH, CopySource, Size );
+            uint32_t Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+            if ( Cycles < Write ) Write = Cycles;
+
+            Start = ( uint32_t ) csr_read_mcycle();
+            rtt_memcpy( CopyTarget, CopySource, Size );
+            Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+            if ( Cycles < Word ) Word = Cycles;
+
+            Start = ( uint32_t ) csr_read_mcycle();
+            rtt_memcpy( CopyTarget, ( const uint8_t * ) CopySource + 1, Size );
+            Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+            if ( Cycles < Misaligned ) Misaligned = Cycles;
+
+            Start = ( uint32_t ) csr_read_mcycle();
+            memcpy( CopyTarget, ( const uint8_t * ) CopySource + 1, Size );
+            Cycles = ( uint32_t ) csr_read_mcycle() - Start;
+            if ( Cycles < Libc ) Libc = Cycles;
+
+            csr_write_mstatus( Mstatus );
+        }
+
+        printf( "%4u bytes: SEGGER_RTT_Write %u, rtt_memcpy %u (misaligned %u), memcpy misaligned %u cycles.\n",
+                ( unsigned int ) Size,
+                ( unsigned int ) Write,
+                ( unsigned int ) Word,
+                ( unsigned int ) Misaligned,
+                ( unsigned int ) Libc );
+    }
+
+    println( "###### RTT copy Tests done. ######" );
+}
+
+/**
+ * @brief   Сравнивает стоимость отложенного бинарного лога и форматирования на цели.
+ *
+ */
+void RttLogBenchmark()
+{
+    // 50 записей по 16 байт помещаются в буфер лога, даже если хост его не читает.
+    const uint32_t Count = 50;
+
+    println( "###### Testing deferred RTT log ######" );
+
+    uint32_t Dropped = rtt_log_dropped;
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+    for ( uint32_t i = 0; i < Count; i++ ) RTT_LOG( "log benchmark %u: mcycle 0x%08X\n", i, Start );
+
+    uint32_t LogCycles = ( ( uint32_t ) csr_read_mcycle() - Start ) / Count;
+
+    // Тот же текст через SEGGER_RTT_printf() в канал замеров.
+    RttBenchReset();
+    Start = ( uint32_t ) csr_read_mcycle();
+
+    SEGGER_RTT_printf( RTT_CHANNEL_BENCH, "log benchmark %u: mcycle 0x%08X\n", Count, Start );
+
+    uint32_t PrintfCycles = ( uint32_t ) csr_read_mcycle() - Start;
+
+    printf( "RTT_LOG %u cycles, SEGGER_RTT_printf %u cycles, %u records dropped.\n",
+            ( unsigned int ) LogCycles,
+            ( unsigned int ) PrintfCycles,
+            ( unsigned int ) ( rtt_log_dropped - Dropped ) );
+
+    println( "###### RTT log Tests done. ######" );
+}
+
+/**
+ * @brief   Вывод fmt::print_to() в терминал RTT.
+ *
+ */
+static void RttTerminalWrite( const char *Data, size_t Size )
+{
+    rtt_channel_write( RTT_CHANNEL_TERMINAL, Data, Size );
+}
+
+/**
+ * @brief   Тот же движок с разбором формата при выполнении, как vsnprintf() из printf.cpp.
+ *
+ */
+static int FormatRuntime( char *Buf, size_t Size, const char *Format, ... )
+{
+    va_list Args;
+    fmt::buffer_output Out( Buf, Size );
+
+    va_start( Args, Format );
+    int Result = fmt::vformat( Out, Format, Args );
+    va_end( Args );
+
+    Out.finish();
+    return Result;
+}
+
+/**
+ * @brief   Сравнивает fmt::format_to() (формат разобран при компиляции), vformat() (разбор
+ *          при выполнении) и snprintf() из newlib-nano на одной строке.
+ *
+ */
+void FormatBenchmark()
+{
+    const uint32_t Count = 20;
+    char Buf[64];
+    uint32_t Compiled = 0, Runtime = 0, Nano = 0;
+
+    println( "###### Testing formatter ######" );
+
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();
+        fmt::format_to( Buf, FMT( "id %5u val %-8d hex 0x%08X\n" ), i, -( int ) i * 1000, Start );
+        Compiled += ( uint32_t ) csr_read_mcycle() - Start;
+
+        Start = ( uint32_t ) csr_read_mcycle();
+        FormatRuntime( Buf, sizeof( Buf ), "id %5u val %-8d hex 0x%08X\n",
+                       ( unsigned int ) i, -( int ) i * 1000, ( unsigned int ) Start );
+        Runtime += ( uint32_t ) csr_read_mcycle() - Start;
+
+        Start = ( uint32_t ) csr_read_mcycle();
+        snprintf( Buf, sizeof( Buf ), "id %5u val %-8d hex 0x%08X\n",
+                  ( unsigned int ) i, -( int ) i * 1000, ( unsigned int ) Start );
+        Nano += ( uint32_t ) csr_read_mcycle() - Start;
+    }
+
+    printf( "format_to %u cycles, vformat %u cycles, newlib-nano snprintf %u cycles.\n",
+            ( unsigned int ) ( Compiled / Count ),
+            ( unsigned int ) ( Runtime / Count ),
+            ( unsigned int ) ( Nano / Count ) );
+
+    // 64-битные и дробные значения: newlib-nano без _printf_float их не выводит,
+    // SEGGER_RTT_printf() не поддерживает ни то, ни другое.
+    uint64_t Mtime = mtimer_get_raw_time();
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+    fmt::print_to( RttTerminalWrite, FMT( "mtime %llu, %.3f V, %.2f C\n" ), Mtime, 3.3f, fmt::q<8>( 25 * 256 + 128 ) );
+
+    printf( "fmt::print with 64-bit, float and Q24.8 arguments to RTT %u cycles.\n",
+            ( unsigned int ) ( ( uint32_t ) csr_read_mcycle() - Start ) );
+
+    println( "###### Formatter Tests done. ######" );
+}
+
+/**
+ * @brief   Замер производительности RTT по образцу Main_RTT_SpeedTestApp.c: стоимость
+ *          записи 0 и 82 байт и поток строк в канал замеров в течение 1 с.
+ *
+ */
+void RttSpeedTest()
+{
+    static const char Line[] = "01234567890123456789012345678901234567890123456789012345678901234567890123456789\r\n";
+    // 10 строк по 82 байта помещаются в буфер канала замеров целиком.
+    const uint32_t Count = 10;
+    uint32_t Empty = 0, Full = 0;
+
+    println( "###### Testing RTT throughput ######" );
+
+    RttBenchReset();
+
+    for ( uint32_t i = 0; i < Count; i++ )
+    {
+        // Пустая запись - накладные расходы RTT без копирования.
+        uint32_t Start = ( uint32_t ) csr_read_mcycle();
+        rtt_channel_write( RTT_CHANNEL_BENCH, NULL, 0 );
+        Empty += ( uint32_t ) csr_read_mcycle() - Start;
+
+        Start = ( uint32_t ) csr_read_mcycle();
+        rtt_channel_write( RTT_CHANNEL_BENCH, Line, sizeof( Line ) - 1 );
+        Full += ( uint32_t ) csr_read_mcycle() - Start;
+    }
+
+    printf( "RTT write: 0 bytes %u cycles, %u bytes %u cycles.\n",
+            ( unsigned int ) ( Empty / Count ),
+            ( unsigned int ) ( sizeof( Line ) - 1 ),
+            ( unsigned int ) ( Full / Count ) );
+
+    // Поток в течение 1 с: без хоста кольцо заполняется и остальное отбрасывается,
+    // при чтении канала 1 хостом сохранённый объём - пропускная способность отладчика.
+    volatile rtt_channel_stats_t &Stats = rtt_channel_stats[RTT_CHANNEL_BENCH];
+    uint32_t Written = Stats.written, Dropped = Stats.dropped;
+    uint64_t End = mtimer_get_raw_time() + MTIMER_MSEC_TO_CLOCKS( 1000 );
+
+    while ( mtimer_get_raw_time() < End ) rtt_channel_write( RTT_CHANNEL_BENCH, Line, sizeof( Line ) - 1 );
+
+    printf( "RTT stream: %u bytes/s stored, %u bytes/s dropped.\n",
+            ( unsigned int ) ( Stats.written - Written ),
+            ( unsigned int ) ( Stats.dropped - Dropped ) );
+
+    println( "###### RTT throughput Tests done. ######" );
+}
+
+static volatile uint32_t ProfilerSink;
+
+/**
+ * @brief   Нагрузка для профилировщика: побитовый CRC-32.
+ *
+ */
+static uint32_t ProfilerCrc32( const void *Data, uint32_t Size )
+{
+    const uint8_t *p = ( const uint8_t * ) Data;
+    uint32_t Crc = 0xFFFFFFFF;
+
+    while ( Size-- )
+    {
+        Crc ^= *p++;
+
+        for ( uint32_t Bit = 0; Bit < 8; Bit++ ) Crc = ( Crc >> 1 ) ^ ( 0xEDB88320 & -( Crc & 1 ) );
+    }
+
+    return ~Crc;
+}
+
+/**
+ * @brief   Профилирует тестовую нагрузку в течение 200 мс и выводит стоимость выборки.
+ *
+ */
+void ProfilerTest()
+{
+    println( "###### Testing sampling profiler ######" );
+
+    rtt_prof_stats_reset();
+
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+    uint64_t End = mtimer_get_raw_time() + MTIMER_MSEC_TO_CLOCKS( 200 );
+
+    rtt_prof_start( RTT_PROF_RATE_HZ );
+
+    while ( mtimer_get_raw_time() < End )
+    {
+        ProfilerSink = ProfilerCrc32( CopySource, sizeof( CopySource ) );
+        rtt_memcpy( CopyTarget, CopySource, sizeof( CopyTarget ) );
+    }
+
+    rtt_prof_stop();
+
+    uint32_t Elapsed = ( uint32_t ) csr_read_mcycle() - Start;
+    rtt_prof_stats_t Stats = const_cast<const rtt_prof_stats_t &>( rtt_prof_stats );
+    uint32_t Samples = Stats.samples + Stats.dropped;
+
+    printf( "Profiler at %u Hz: %u samples, %u dropped, %u cycles per sample (max %u), overhead %u ppm.\n",
+            ( unsigned int ) RTT_PROF_RATE_HZ,
+            ( unsigned int ) Stats.samples,
+            ( unsigned int ) Stats.dropped,
+            ( unsigned int ) ( Samples ? Stats.sum_cycles / Samples : 0 ),
+            ( unsigned int ) Stats.max_cycles,
+            ( unsigned int ) ( Stats.sum_cycles * 1000000 / Elapsed ) );
+
+    println( "###### Profiler Tests done. ######" );
+}
+
+static swtimer_t TraceTimer;
+
+static void TraceTimerCallback( swtimer_t *, void * )
+{
+    ProfilerSink = ProfilerCrc32( CopySource, 64 );
+}
+
+/**
+ * @brief   Пишет трассу ~100 мс: периодический программный таймер, задержки sleep() и
+ *          пользовательские отрезки и метки, затем выводит стоимость одного события.
+ *          Канал трассы переводится в Chrome trace JSON скриптом tools/rtt_trace.py.
+ *
+ */
+void TraceTest()
+{
+    const uint32_t Count = 16;
+
+    println( "###### Testing event trace ######" );
+
+    trace_stats_t Before = const_cast<const trace_stats_t &>( trace_stats );
+
+    swtimer_setup( &TraceTimer, TraceTimerCallback, 0 );
+    rtt_trace_start();
+    swtimer_start( &TraceTimer, SWTIMER_MSEC_TO_TICKS( 1 ), SWTIMER_MSEC_TO_TICKS( 1 ) );
+
+    for ( uint32_t i = 0; i < 10; i++ )
+    {
+        trace_span_begin( 1 );
+        ProfilerSink = ProfilerCrc32( CopySource, sizeof( CopySource ) );
+        trace_span_end( 1 );
+
+        trace_mark( i );
+        sleep( 10 );
+    }
+
+    swtimer_stop( &TraceTimer );
+
+    // Стоимость события: метка с полезной нагрузкой.
+    uint32_t Start = ( uint32_t ) csr_read_mcycle();
+
+    for ( uint32_t i = 0; i < Count; i++ ) trace_mark( i );
+
+    uint32_t Cycles = ( ( uint32_t ) csr_read_mcycle() - Start ) / Count;
+
+    rtt_trace_stop();
+
+    trace_stats_t After = const_cast<const trace_stats_t &>( trace_stats );
+
+    printf( "Trace: %u events, %u lost, %u cycles per event.\n",
+            ( unsigned int ) ( After.events - Before.events ),
+            ( unsigned int ) ( After.lost - Before.lost ),
+            ( unsigned int ) Cycles );
+
+    println( "###### Event trace Tests done. ######" );
+}
+
+/**
+ * @brief   Выводит счётчики каналов RTT.
+ *
+ */
+void RttChannelStatsDump()
+{
+    rtt_channel_poll();
+
+    // Копия, т.к. printf() сам пишет в канал терминала.
+    rtt_channel_stats_t Stats[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
+    for ( uint32_t i = 0; i < SEGGER_RTT_MAX_NUM_UP_BUFFERS; i++ ) Stats[i] = const_cast<const rtt_channel_stats_t &>( rtt_channel_stats[i] );
+
+    println( "###### RTT channels ######" );
+
+    for ( uint32_t i = 0; i < SEGGER_RTT_MAX_NUM_UP_BUFFERS; i++ )
+    {
+        printf( "%u %s: size %u, written %u, dropped %u, high water %u.\n",
+                ( unsigned int ) i,
+                _SEGGER_RTT.aUp[i].sName ? _SEGGER_RTT.aUp[i].sName : "-",
+                ( unsigned int ) _SEGGER_RTT.aUp[i].SizeOfBuffer,
+                ( unsigned int ) Stats[i].written,
+                ( unsigned int ) Stats[i].dropped,
+                ( unsigned int ) Stats[i].high_water );
+    }
+
+    printf( "Channel pool: %u bytes free.\n", rtt_channel_pool_free() );
+}
+
+/**
+ * @brief   Выводит таблицу статистики прерываний.
+ *
+ */
+void IrqStatsDump()
+{
+    // Копия, т.к. printf() сам вызывает sleep() и может вызвать прерывания.
+    irq_stats_t Stats = const_cast<const irq_stats_t &>( irq_stats );
+
+    println( "###### IRQ statistics (cycles) ######" );
+
+    for ( uint32_t i = 0; i < IRQ_STATS_NUM; i++ )
+    {
+        const irq_stats_entry_t &Entry = Stats.irq[i];
+
+        if ( Entry.count == 0 ) continue;
+
+        printf( "%s%2u: count %u, latency avg %u max %u, dispatch avg %u max %u, duration avg %u max %u.\n",
+                i < IRQ_STATS_CORE( 0 ) ? "PLIC " : "CORE ",
+                ( unsigned int ) ( i < IRQ_STATS_CORE( 0 ) ? i : i - IRQ_STATS_CORE( 0 ) ),
+                ( unsigned int ) Entry.count,
+                ( unsigned int ) ( Entry.sum_latency / Entry.count ),
+                ( unsigned int ) Entry.max_latency,
+                ( unsigned int ) ( Entry.sum_dispatch / Entry.count ),
+                ( unsigned int ) Entry.max_dispatch,
+                ( unsigned int ) ( Entry.sum_duration / Entry.count ),
+                ( unsigned int ) Entry.max_duration );
+    }
+
+    printf( "Max nesting depth: %u.\n", ( unsigned int ) Stats.max_depth );
+}
+
+/**
+ * @brief   Выводит использование стека и кучи.
+ *
+ */
+void MemStatsDump()
+{
+    // Проход до конца, чтобы пик был актуален.
+    while ( !mem_stats_scan() ) {}
+
+    mem_stats_t Stats = const_cast<const mem_stats_t &>( mem_stats );
+
+    println( "###### Memory usage (bytes) ######" );
+
+    printf( "Stack: peak %u of %u%s.\n",
+            ( unsigned int ) Stats.stack_peak,
+            ( unsigned int ) Stats.stack_size,
+            Stats.stack_overflow ? ", OVERFLOW" : "" );
+
+    printf( "Heap: used %u, peak %u of %u, failed %u.\n",
+            ( unsigned int ) Stats.heap_used,
+            ( unsigned int ) Stats.heap_peak,
+            ( unsigned int ) Stats.heap_size,
+            ( unsigned int ) Stats.heap_failed );
+
+    printf( "Scan: %u cycles.\n", ( unsigned int ) Stats.last_scan_cycles );
+}
+
+int BenchShell( int argc, char *argv[] )
+{
+    static const struct
+    {
+        const char *Name;
+        void ( *Func )();
+    } Benchmarks[] =
+    {
+        { "sleep",   SleepLatencyTest },
+        { "irq",     IrqLatencyTest },
+        { "ramfunc", RamFuncBenchmark },
+        { "flash",   FlashLatencyBenchmark },
+        { "perf",    PerfSwitchBenchmark },
+        { "swtimer", SwTimerBenchmark },
+        { "write",   RttWriteBenchmark },
+        { "copy",    RttCopyBenchmark },
+        { "log",     RttLogBenchmark },
+        { "format",  FormatBenchmark },
+        { "speed",   RttSpeedTest },
+        { "prof",    ProfilerTest },
+        { "trace",   TraceTest },
+    };
+
+    if ( argc != 2 ) return -1;
+
+    for ( const auto &Bench : Benchmarks )
+    {
+        if ( strcmp( argv[1], Bench.Name ) == 0 )
+        {
+            Bench.Func();
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+void BenchRunAll()
+{
+    // Канал замеров.
+    rtt_channel_setup( RTT_CHANNEL_BENCH, "Bench", 2048, SEGGER_RTT_MODE_NO_BLOCK_SKIP );
+
+    // Измеряем точность задержек.
+    SleepLatencyTest();
+
+    // Измеряем задержку входа в прерывание.
+    IrqLatencyTest();
+
+    // Обработчик прерывания из флеш и из RAM.
+    RamFuncBenchmark();
+
+    // Производительность при разных задержках флеш.
+    FlashLatencyBenchmark();
+
+    // Переключение уровней производительности.
+    PerfSwitchBenchmark();
+
+    // Измеряем стоимость программных таймеров.
+    SwTimerBenchmark();
+
+    // Сравниваем пути записи в RTT.
+    RttWriteBenchmark();
+
+    // Копирование в кольцо RTT на разных размерах.
+    RttCopyBenchmark();
+
+    // Сравниваем бинарный лог с форматированием на цели.
+    RttLogBenchmark();
+
+    // Форматирование с разбором формата при компиляции против newlib-nano.
+    FormatBenchmark();
+
+    // Пропускная способность RTT.
+    RttSpeedTest();
+
+    // Профилируем тестовую нагрузку.
+    ProfilerTest();
+
+    // Трасса прерываний, таймеров и задержек.
+    TraceTest();
+
+    // Счётчики каналов RTT.
+    RttChannelStatsDump();
+
+    // Статистика прерываний за время тестов.
+    IrqStatsDump();
+
+    // Глубина стека и куча за время тестов.
+    MemStatsDump();
+}
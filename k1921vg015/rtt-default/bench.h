@@ -0,0 +1,18 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// Замеры производительности, собираются с опцией RTT_BENCH (см. CMakeLists.txt).
+
+/**
+ * @brief   Настраивает канал замеров и выполняет все замеры с выводом итоговой статистики.
+ *
+ */
+void BenchRunAll();
+
+/**
+ * @brief   Команда shell: bench <имя> - запуск замера по имени.
+ *
+ */
+int BenchShell( int argc, char *argv[] );
+
+#endif // _BENCH_H_
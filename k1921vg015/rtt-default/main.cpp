@@ -1,16 +1,32 @@
 #include <K1921VG015.h>
 #include <system_k1921vg015.h>
+#include <cstring>
 extern "C" {
 #include <mtimer.h>
+#include <swtimer.h>
+#include <mem_stats.h>
+#include <sys_init.h>
+#include <perf.h>
 }
 #include "SEGGER_RTT.h"
+#include "rtt_channel.h"
+#include "rtt_log.h"
+#include "rtt_prof.h"
+#include "rtt_shell.h"
+#include "rtt_trace.h"
 #include "version.h"
+#include "shell.h"
+#include "bench.h"
 
 // SEGGER RTT: IP: localhost, PORT: 19021.
-#define print(s)                        SEGGER_RTT_WriteString( 0, s ); sleep(1)
+#define print(s)                        rtt_channel_write( RTT_CHANNEL_TERMINAL, s, sizeof( s ) - 1 ); sleep(1)
 #define println(s)                      print( s "\n" )
 #define printf( format, ... )           SEGGER_RTT_printf( 0, ( const char * ) ( format ), ##__VA_ARGS__ ); sleep(1)
 
+// Делители USB PLL для 48 МГц рассчитываются при компиляции, недостижимая частота - ошибка сборки.
+static constexpr pll_config_t UsbPll = pll_solve( HSECLK_VAL, 48000000, 0 );
+static_assert( UsbPll.valid && UsbPll.out0_hz == 48000000, "USB PLL: 48 MHz cannot be reached from HSECLK_VAL" );
+
 /**
  * @brief   Выполняет тестирование RTT.
  *
@@ -102,14 +118,29 @@ void RTT_PrintfTest()
  */
 int main( void )
 {
+    // Время от сброса до main() (до SystemInit(), на частоте после сброса).
+    boot_stats_main();
+
     // Инициализация системы.
     SystemInit();
 
     // Обновление системной частоты.
     SystemCoreClockUpdate();
 
+    // Уровни производительности от частоты PLL, выбранной при старте.
+    perf_init();
+
     // Настраиваем терминал 0 для работы в неблокирующем режиме.
-    SEGGER_RTT_ConfigUpBuffer( 0, NULL, NULL, 0, SEGGER_RTT_MODE_NO_BLOCK_TRIM );
+    rtt_channel_setup( RTT_CHANNEL_TERMINAL, "Terminal", 0, SEGGER_RTT_MODE_NO_BLOCK_TRIM );
+
+    // Канал отложенного бинарного лога (декодируется tools/rtt_log_decode.py).
+    rtt_log_init();
+
+    // Канал выборок профилировщика (обрабатывается tools/rtt_prof.py).
+    rtt_prof_init();
+
+    // Канал трассы событий (преобразуется в Chrome trace tools/rtt_trace.py).
+    rtt_trace_init();
 
     println( "SEGGER Real-Time-Terminal Sample" );
 
@@ -118,6 +149,19 @@ int main( void )
 
     printf( "  K1921VG015 SYSCLK = %d MHz\n", ( int ) ( SystemCoreClock / 1E6 ) );
 
+    // Делители PLL, рассчитанные при компиляции (clk_config.h), и частота по регистрам.
+    printf( "  PLL: REFDIV %u, FBDIV %u, FRAC %u, PD0 %u*%u, PD1 %u*%u, USB PD0 %u*%u, SYSCLK %s\n",
+            ( unsigned int ) PLL_SYS_REFDIV,
+            ( unsigned int ) PLL_SYS_FBDIV,
+            ( unsigned int ) PLL_SYS_FRAC,
+            ( unsigned int ) PLL_SYS_PD0A,
+            ( unsigned int ) PLL_SYS_PD0B,
+            ( unsigned int ) PLL_SYS_PD1A,
+            ( unsigned int ) PLL_SYS_PD1B,
+            ( unsigned int ) UsbPll.pd0a,
+            ( unsigned int ) UsbPll.pd0b,
+            SystemCoreClock == SYSTEM_CORE_CLOCK_HZ ? "matches" : "differs" );
+
     printf( "  UID[0] = 0x%X  UID[1] = 0x%X  UID[2] = 0x%X  UID[3] = 0x%X\n",
             ( unsigned int ) PMUSYS->UID[0],
             ( unsigned int ) PMUSYS->UID[1],
@@ -128,14 +172,30 @@ int main( void )
     printf( "  Build Date:    %s\n", __DATE__ );
     printf( "  Build Time:    %s\n", __TIME__ );
 
+    // Время загрузки в тактах mcycle.
+    printf( "  Boot: reset to main() %u cycles (startup %u, init %u, constructors %u)\n",
+            ( unsigned int ) boot_stats.main_start,
+            ( unsigned int ) boot_stats.init_start,
+            ( unsigned int ) boot_stats.init_cycles,
+            ( unsigned int ) boot_stats.ctors_cycles );
+
     // Версия прошивки.
     printf( "  Version: %u.%u.%u.%u (%02u.%02u.%02u %02u:%02u:%02u)\n",
             Version.Major, Version.Minor, Version.Build, Version.Revision,
             DAY, MON, YEAR, HOUR, MIN, SEC );
 
+    // Включаем прерывания и программные таймеры (после InterruptEnable(), т.к. он запрещает MTIE).
+    InterruptEnable();
+    swtimer_init();
+
     // Тестируем RTT.
     RTT_PrintfTest();
 
+#ifdef RTT_BENCH
+    // Замеры производительности (опция RTT_BENCH).
+    BenchRunAll();
+#endif // RTT_BENCH
+
     // Разрешаем тактирование GPIOC.
     RCU->CGCFGAHB_bit.GPIOCEN = 1;
 
@@ -145,11 +205,19 @@ int main( void )
     GPIOC->OUTENSET = ( 1 << 0 );
     GPIOC->DATAOUTSET = ( 1 << 0 );
 
+    // Команды из терминала RTT (канал 0 вниз).
+    ShellInit();
+
     // Мигаем светодиодом на плате.
     while ( 1 )
     {
         sleep( 100 ); // мс
 
+        rtt_shell_poll();
+
+        // Отметка наибольшей глубины стека: часть прохода, не более MEM_STATS_SCAN_WORDS слов.
+        mem_stats_scan();
+
         GPIOC->DATAOUTTGL |= ( 1 << 0 );
     }
 }
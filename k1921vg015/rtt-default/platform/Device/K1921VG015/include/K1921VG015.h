@@ -86,6 +86,8 @@ typedef enum Plic_IsrVect {
 #define MEM_FLASH_PAGE_SIZE_LOG2             12UL
 #define MEM_FLASH_PAGE_TOTAL                 256UL
 #define MEM_FLASH_SIZE                       (MEM_FLASH_PAGE_TOTAL*MEM_FLASH_PAGE_SIZE)
+#define MEM_FLASH_NVR_PAGE_TOTAL             2UL
+#define MEM_FLASH_NVR_SIZE                   (MEM_FLASH_NVR_PAGE_TOTAL*MEM_FLASH_PAGE_SIZE)
 #define MEM_RAM0_BASE                         0x40000000UL
 #define MEM_RAM0_SIZE                         0x40000UL
 #define MEM_RAM1_BASE                         0x10000000UL
@@ -0,0 +1,59 @@
+#ifndef FLASH_TIMING_H
+#define FLASH_TIMING_H
+
+#include <stdint.h>
+
+/** Flash wait states and instruction cache.
+ *
+ * A flash read takes FLASH_ACCESS_NS, CTRL.LAT is the number of extra clocks
+ * per read, so the minimum safe value is ceil(f * FLASH_ACCESS_NS) - 1. The
+ * default access time matches the vendor setting LAT = 3 for the 50 MHz PLL.
+ *
+ * LAT has to be raised before the clock goes up and may only be lowered after
+ * it went down: ClkInit() calls flash_timing_prepare() with the PLL frequency
+ * before the switch, SystemCoreClockUpdate() calls flash_timing_update() with
+ * the clock it has computed, which also enables the cache.
+ */
+
+#ifndef FLASH_ACCESS_NS
+#define FLASH_ACCESS_NS 80
+#endif
+
+#define FLASH_LAT_MAX 15
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Minimum safe LAT for a core clock in Hz.
+ */
+uint32_t flash_latency_for(uint32_t hz);
+
+/** Raise LAT for a clock that is about to be selected, never lowers it.
+ */
+void flash_timing_prepare(uint32_t hz);
+
+/** Set the minimum LAT for the current clock and enable the cache.
+ */
+void flash_timing_update(uint32_t hz);
+
+/** Current LAT.
+ */
+uint32_t flash_latency_get(void);
+
+/** Set LAT explicitly, e.g. for benchmarks.
+ * Values below flash_latency_for(SystemCoreClock) are refused with -1.
+ */
+int flash_latency_set(uint32_t lat);
+
+void flash_cache_enable(int enable);
+
+/** Drop all cached lines, required after the flash was programmed or erased.
+ */
+void flash_cache_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_TIMING_H
@@ -171,6 +171,54 @@ _use_trap_stack:
     load_reg 2, sp           // restore original sp
 .endm // context_restore
 
+#if PLF_TRAP_FAST_IRQ
+// interrupt frame: ra, t0-t2, a0-a7, t3-t6, mepc, mstatus
+#define IRQ_FRAME_MEPC    16
+#define IRQ_FRAME_MSTATUS 17
+#define IRQ_FRAME_SPACE   ((4*(IRQ_FRAME_MSTATUS+1)*__riscv_xlen/32 + 0xf) & ~0xf)
+
+.macro irq_save_caller_regs
+    save_reg_offs ra,  0, sp
+    save_reg_offs t1,  2, sp
+    save_reg_offs t2,  3, sp
+    save_reg_offs a0,  4, sp
+    save_reg_offs a1,  5, sp
+    save_reg_offs a2,  6, sp
+    save_reg_offs a3,  7, sp
+    save_reg_offs a4,  8, sp
+    save_reg_offs a5,  9, sp
+#ifndef __riscv_32e
+    save_reg_offs a6, 10, sp
+    save_reg_offs a7, 11, sp
+    save_reg_offs t3, 12, sp
+    save_reg_offs t4, 13, sp
+    save_reg_offs t5, 14, sp
+    save_reg_offs t6, 15, sp
+#endif // __riscv_32e
+.endm // irq_save_caller_regs
+
+.macro irq_restore_caller_regs
+    load_reg_offs ra,  0, sp
+    load_reg_offs t0,  1, sp
+    load_reg_offs t1,  2, sp
+    load_reg_offs t2,  3, sp
+    load_reg_offs a0,  4, sp
+    load_reg_offs a1,  5, sp
+    load_reg_offs a2,  6, sp
+    load_reg_offs a3,  7, sp
+    load_reg_offs a4,  8, sp
+    load_reg_offs a5,  9, sp
+#ifndef __riscv_32e
+    load_reg_offs a6, 10, sp
+    load_reg_offs a7, 11, sp
+    load_reg_offs t3, 12, sp
+    load_reg_offs t4, 13, sp
+    load_reg_offs t5, 14, sp
+    load_reg_offs t6, 15, sp
+#endif // __riscv_32e
+.endm // irq_restore_caller_regs
+#endif // PLF_TRAP_FAST_IRQ
+
 ### ##############################
 ### addr load/read/write routines
 
@@ -55,6 +55,13 @@ enum Plic_Target {
 
 typedef void irqfunc(void);
 
+/*
+ * PLIC_NESTED_IRQ: PLIC_MachHandler() raises MTHR to the priority of the claimed
+ * source and re-enables MIE while its handler runs, so higher priority sources
+ * (and the core-local timer) preempt it. Every nesting level adds a trap frame
+ * to the current stack.
+ */
+
 void PLIC_SetIrqHandler (uint8_t target, uint32_t isr_num, irqfunc* func);
 void PLIC_SetPriority (uint32_t isr_num, uint8_t pri);
 //void PLIC_SetMode (uint32_t isr_num, Plic_IrqMode_TypeDef mode);
@@ -47,6 +47,9 @@ enum {
     RISCV_EXCP_STORE_AMO_PAGE_FAULT=15,	/* Store/AMO page fault */
 };
 
+// Handlers of core-local interrupts, also used by trap_handler() in plic.c
+extern irqfunc_t* riscv_handler_map[RISCV_IRQ_NUMS];
+
 void riscv_irq_init(void);
 void riscv_irq_enable(unsigned int irq);
 void riscv_irq_disable(unsigned int irq);
@@ -0,0 +1,36 @@
+#ifndef SYS_INIT_H
+#define SYS_INIT_H
+
+#include <stdint.h>
+
+#include "riscv-csr.h"
+
+/** Boot time stamps, mcycle counts since reset.
+ *
+ * plf_init_generic() fills in the first three, main() calls boot_stats_main()
+ * first thing. mcycle is reset to zero together with the core, so init_start
+ * is the startup code time and main_start the whole reset-to-main() time.
+ * The stamps are taken before SystemInit(), i.e. at the reset clock.
+ */
+typedef struct {
+    uint32_t init_start;    // plf_init() entry
+    uint32_t init_cycles;   // .data/.sdata copy, .bss zeroing and painting
+    uint32_t ctors_cycles;  // C++ constructors
+    uint32_t main_start;    // main() entry
+} boot_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile boot_stats_t boot_stats;
+
+static inline void boot_stats_main(void) {
+    boot_stats.main_start = (uint32_t)csr_read_mcycle();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_INIT_H
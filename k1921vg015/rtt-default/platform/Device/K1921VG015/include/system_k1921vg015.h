@@ -30,20 +30,11 @@ extern "C" {
 #include "csr.h"
 #include "arch.h"
 #include "plic.h"
+#include "clk_config.h"
 
 //-- Defines -------------------------------------------------------------------
-#ifndef HSECLK_VAL
-#define HSECLK_VAL 0
-#endif
-
 #define OSECLK_STARTUP_TIMEOUT 0x100000
 #define SYSCLK_SWITCH_TIMEOUT 0x100000
-#ifndef HSICLK_VAL
-    #define HSICLK_VAL 1000000
-#endif
-#ifndef LSICLK_VAL
-    #define LSICLK_VAL 32768
-#endif
 
 
 // machine irq handler
@@ -0,0 +1,201 @@
+#include "perf.h"
+#include "flash_timing.h"
+#include "mtimer.h"
+#include "trace.h"
+#include "riscv-csr.h"
+#include "system_k1921vg015.h"
+#include "K1921VG015.h"
+
+#if HSECLK_VAL == 0
+#error "perf.c switches through HSE, define HSECLK_VAL"
+#endif
+
+#define PERF_SWITCH_TIMEOUT 1000
+// Delay before the lock bit is trusted after the PLL was reconfigured, as in ClkInit()
+#define PERF_LOCK_SETTLE_CLOCKS 1000
+
+enum { PLL_PROFILE(PERF_MID, HSECLK_VAL, PERF_MID_HZ, SYSCLK_PLL1_HZ) };
+
+_Static_assert(PERF_MID_VALID, "PERF_MID_HZ / SYSCLK_PLL1_HZ cannot be reached from HSECLK_VAL");
+_Static_assert(PLL_PROFILE_EXACT(PERF_MID, PERF_MID_HZ, SYSCLK_PLL1_HZ),
+               "PERF_MID_HZ / SYSCLK_PLL1_HZ are only reached approximately, see SYSCLK_PLL_TOLERANCE_HZ");
+
+/** PLL profiles of the levels, PERF_LEVEL_LOW runs from HSE.
+ */
+static const pll_config_t perf_profiles[PERF_LEVEL_NUM] = {
+    [PERF_LEVEL_MID] = PLL_PROFILE_CONFIG(PERF_MID),
+    [PERF_LEVEL_HIGH] = PLL_PROFILE_CONFIG(PLL_SYS),
+};
+
+volatile perf_stats_t perf_stats;
+
+static perf_notifier_t *perf_notifiers;
+static perf_level_t perf_level = PERF_LEVEL_HIGH;
+static int perf_pll;                         // The boot clock is the PLL
+
+static void perf_notify(perf_event_t event, uint32_t hz)
+{
+    for (perf_notifier_t *notifier = perf_notifiers; notifier; notifier = notifier->next)
+        notifier->func(notifier, event, hz);
+}
+
+/** Select the SYSCLK source and wait for the switch, 0 on success.
+ */
+static int perf_select(uint32_t src)
+{
+    uint32_t timeout = PERF_SWITCH_TIMEOUT;
+
+    RCU->SYSCLKCFG = src << RCU_SYSCLKCFG_SRC_Pos;
+    while (RCU->CLKSTAT_bit.SRC != src)
+        if (--timeout == 0) return -1;
+
+    return 0;
+}
+
+/** Program all dividers of a profile, SYSCLK must run from HSE. The VCO keeps
+ * its lock if only the output dividers change, otherwise the lock is awaited
+ * for at most PERF_LOCK_TIMEOUT_US. 0 on success.
+ */
+static int perf_pll_program(const pll_config_t *pll)
+{
+    uint32_t cfg0 = ((pll->pd1b - 1) << RCU_PLLSYSCFG0_PD1B_Pos) |
+                    ((pll->pd1a - 1) << RCU_PLLSYSCFG0_PD1A_Pos) |
+                    ((pll->pd0b - 1) << RCU_PLLSYSCFG0_PD0B_Pos) |
+                    ((pll->pd0a - 1) << RCU_PLLSYSCFG0_PD0A_Pos) |
+                    (pll->refdiv << RCU_PLLSYSCFG0_REFDIV_Pos) |
+                    ((pll->frac != 0) << RCU_PLLSYSCFG0_DSMEN_Pos) |
+                    (1 << RCU_PLLSYSCFG0_PLLEN_Pos);
+
+    if (RCU->PLLSYSSTAT_bit.LOCK && RCU->PLLSYSCFG0_bit.REFDIV == pll->refdiv &&
+        RCU->PLLSYSCFG2 == pll->fbdiv && RCU->PLLSYSCFG1 == pll->frac) {
+        RCU->PLLSYSCFG0 = cfg0 | (1 << RCU_PLLSYSCFG0_FOUTEN_Pos) | (2 << RCU_PLLSYSCFG0_BYP_Pos);
+        return 0;
+    }
+
+    // Same sequence as ClkInit(): both outputs bypassed until the lock
+    RCU->PLLSYSCFG0 = cfg0 | (3 << RCU_PLLSYSCFG0_BYP_Pos);
+    RCU->PLLSYSCFG1 = pll->frac;
+    RCU->PLLSYSCFG2 = pll->fbdiv;
+    RCU->PLLSYSCFG0_bit.FOUTEN = 1;
+
+    uint64_t start = mtimer_get_raw_time();
+    uint64_t timeout = (uint64_t)HSECLK_VAL * PERF_LOCK_TIMEOUT_US / 1000000;
+    uint64_t elapsed;
+
+    do {
+        elapsed = mtimer_get_raw_time() - start;
+        if (elapsed > timeout) return -1;
+    } while (elapsed < PERF_LOCK_SETTLE_CLOCKS || RCU->PLLSYSSTAT_bit.LOCK != 1);
+
+    RCU->PLLSYSCFG0_bit.BYP = 2;
+    return 0;
+}
+
+/** Time of a switch phase in ns.
+ */
+static uint32_t perf_ns(uint32_t cycles, uint32_t hz)
+{
+    return (uint32_t)((uint64_t)cycles * 1000000000 / hz);
+}
+
+void perf_init(void)
+{
+    perf_pll = RCU->CLKSTAT_bit.SRC == RCU_CLKSTAT_SRC_SYSPLL0CLK;
+    perf_level = perf_pll ? PERF_LEVEL_HIGH : PERF_LEVEL_LOW;
+}
+
+uint32_t perf_level_hz(perf_level_t level)
+{
+    if (level == PERF_LEVEL_LOW || !perf_pll) return HSECLK_VAL;
+
+    return perf_profiles[level].out0_hz;
+}
+
+perf_level_t perf_get_level(void)
+{
+    return perf_level;
+}
+
+int perf_set_level(perf_level_t level)
+{
+    if (level >= PERF_LEVEL_NUM || (level != PERF_LEVEL_LOW && !perf_pll)) return -1;
+    if (level == perf_level) return 0;
+
+    uint32_t old_hz = SystemCoreClock;
+    uint32_t new_hz = perf_level_hz(level);
+    int status = 0;
+
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    uint32_t start = (uint32_t)csr_read_mcycle();
+
+    perf_notify(PERF_PRE_CHANGE, new_hz);
+
+    // The PLL dividers are only touched while SYSCLK runs from HSE
+    if (RCU->CLKSTAT_bit.SRC != RCU_CLKSTAT_SRC_HSECLK) status = perf_select(RCU_SYSCLKCFG_SRC_HSECLK);
+
+    uint32_t hse = (uint32_t)csr_read_mcycle();
+
+    // mtime counts SYSCLK: the trace converts each delta with the rate of its interval
+    if (status == 0) trace_freq(HSECLK_VAL);
+
+    if (status == 0 && level != PERF_LEVEL_LOW) {
+        status = perf_pll_program(&perf_profiles[level]);
+
+        if (status == 0) {
+            flash_timing_prepare(new_hz);
+            status = perf_select(RCU_SYSCLKCFG_SRC_SYSPLL0CLK);
+        }
+    }
+
+    uint32_t switched = (uint32_t)csr_read_mcycle();
+
+    // On failure the clock is HSE: keep all globals consistent with it
+    SystemCoreClockUpdate();
+#ifdef MTIMER_DYNAMIC_FREQ
+    mtimer_freq_hz = SystemCoreClock;
+#endif
+    perf_level = status == 0 ? level : PERF_LEVEL_LOW;
+    trace_freq(SystemCoreClock);
+
+    perf_notify(PERF_POST_CHANGE, SystemCoreClock);
+
+    uint32_t end = (uint32_t)csr_read_mcycle();
+    uint32_t ns = perf_ns(hse - start, old_hz) + perf_ns(switched - hse, HSECLK_VAL) +
+                  perf_ns(end - switched, SystemCoreClock);
+
+    perf_stats.switches++;
+    if (status) perf_stats.failed++;
+    perf_stats.last_cycles = end - start;
+    perf_stats.last_ns = ns;
+    if (ns > perf_stats.max_ns) perf_stats.max_ns = ns;
+
+    csr_write_mstatus(mstatus);
+
+    return status;
+}
+
+void perf_notifier_register(perf_notifier_t *notifier, perf_notifier_func_t *func, void *arg)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    notifier->func = func;
+    notifier->arg = arg;
+    notifier->next = perf_notifiers;
+    perf_notifiers = notifier;
+
+    csr_write_mstatus(mstatus);
+}
+
+void perf_notifier_unregister(perf_notifier_t *notifier)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    for (perf_notifier_t **link = &perf_notifiers; *link; link = &(*link)->next) {
+        if (*link == notifier) {
+            *link = notifier->next;
+            break;
+        }
+    }
+
+    csr_write_mstatus(mstatus);
+}
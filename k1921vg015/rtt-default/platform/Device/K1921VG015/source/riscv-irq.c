@@ -1,6 +1,8 @@
 #include "plic.h"
 #include "riscv-irq.h"
 #include "riscv-csr.h"
+#include "irq_stats.h"
+#include "trace.h"
 #include <stdint.h>
 
 // machine irq handler
@@ -46,6 +48,8 @@ void riscv_irq_global_disable(void)
 
 void irq_entry (void)
 {
+	IRQ_STATS_TRAP();
+
 	uint_xlen_t this_cause = csr_read_mcause();
 
 	if((this_cause & MCAUSE_INTERRUPT_BIT_MASK) == 0) {
@@ -81,7 +85,16 @@ void irq_entry (void)
 		//handle interrupt
 		this_cause &= 0xFF;
 		if(riscv_handler_map[this_cause] != 0) {
-                  riscv_handler_map[this_cause]();
+                  if(this_cause == RISCV_IRQ_MEI) {
+                    // PLIC_MachHandler() keeps per-source statistics itself
+                    riscv_handler_map[this_cause]();
+                  } else {
+                    IRQ_STATS_BEGIN(stats);
+                    TRACE_IRQ_ENTER(IRQ_STATS_CORE(this_cause));
+                    riscv_handler_map[this_cause]();
+                    TRACE_IRQ_EXIT(IRQ_STATS_CORE(this_cause));
+                    IRQ_STATS_END(stats, IRQ_STATS_CORE(this_cause));
+                  }
 		}else{
 			while(1) {}; //NO handler
 		}
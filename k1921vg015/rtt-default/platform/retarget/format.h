@@ -0,0 +1,727 @@
+/**************************************************************************//*****
+ * @file     format.h
+ * @brief    Header-only formatter without allocations.
+ *
+ *           The format string is printf-like and is parsed at compile time:
+ *
+ *               char Buf[32];
+ *               fmt::format_to( Buf, FMT( "%s: %08llx %.3f" ), Name, Value64, 1.5f );
+ *               fmt::print_to( Write, FMT( "%d\n" ), Value );
+ *
+ *           FMT() turns the literal into a type, format_to() checks the number
+ *           and the types of the arguments with static_assert and passes the
+ *           pre-parsed conversions to one shared non-template engine. The same
+ *           engine also serves vsnprintf() and friends (printf.cpp), which
+ *           parse the format string at run time.
+ *
+ *           Conversions: %d %i %u %o %x %X %c %s %p %f %%, flags "-0+ #", width
+ *           and .precision. Length modifiers give the argument size as in C
+ *           ("ll" and "j" are 64-bit). In FMT() strings the argument type
+ *           decides, so 64-bit integers need no "ll"; a modifier wider than the
+ *           argument widens it, e.g. %jx of -1 prints 16 digits. %f takes
+ *           float, double and fmt::fixed<FRAC> Q-format values.
+ *
+ *           %f is computed in float, the FPU is single precision: a double
+ *           argument is rounded to 24 bits first (123456789.0 prints as
+ *           123456792.000000) and only 9 fraction digits are computed, the
+ *           digits asked beyond them are zeros.
+ *
+ *           '*' width/precision and %e/%g/%n are not supported: FMT() strings
+ *           with them do not compile, vsnprintf() copies them to the output.
+ *
+ *           The run-time path (vformat()) is kept small by default: integers
+ *           are 32-bit, %f and 64-bit conversions ("ll", "j") are copied to
+ *           the output like the unsupported ones, their argument is skipped.
+ *           Define FMT_RUNTIME_FULL to have them formatted at run time too,
+ *           this pulls in the float and 64-bit division code.
+ ********************************************************************************/
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <type_traits>
+
+/** Format string for fmt::format_to() and fmt::print_to(), checked at compile time.
+ */
+#define FMT(S)                                                                  \
+    ([] {                                                                       \
+        struct fmt_string : fmt::format_string {                                \
+            static constexpr const char *value() { return S; }                  \
+        };                                                                      \
+        return fmt_string{};                                                    \
+    }())
+
+namespace fmt {
+
+/** Base of the format string types made by FMT().
+ */
+struct format_string {};
+
+template <typename S>
+using if_format_string = std::enable_if_t<std::is_base_of_v<format_string, S>, int>;
+
+/** Signed Q-format fixed point value with FRAC fractional bits, printed by %f.
+ */
+template <unsigned FRAC>
+struct fixed {
+    static_assert(FRAC < 32, "fmt::fixed: too many fractional bits");
+    int32_t raw;
+};
+
+template <unsigned FRAC>
+constexpr fixed<FRAC> q(int32_t raw) { return fixed<FRAC>{raw}; }
+
+/** Output sink. The characters go to the window [ptr, end) directly, what
+ * does not fit is passed to overflow(), which may flush the window and reset
+ * it. count is the length of the whole output, including what the sink
+ * could not store.
+ */
+struct output {
+    char *ptr;
+    char *end;
+    void (*overflow)(output *out, const char *data, size_t size);
+    size_t count;
+
+    void write(const char *data, size_t size) {
+        count += size;
+        if (size <= (size_t)(end - ptr)) {
+            while (size--) *ptr++ = *data++;
+        } else {
+            overflow(this, data, size);
+        }
+    }
+};
+
+/** Sink into a caller buffer with snprintf() semantics: at most size - 1
+ * characters are stored, the buffer is always terminated (if size is not 0).
+ */
+struct buffer_output : output {
+    buffer_output(char *buf, size_t size)
+        : output{size ? buf : nullptr, size ? buf + size - 1 : nullptr, put, 0} {}
+
+    void finish() {
+        if (ptr) *ptr = 0;
+    }
+
+    static void put(output *out, const char *data, size_t) {
+        while (out->ptr != out->end) *out->ptr++ = *data++;
+    }
+};
+
+/** Sink to a stream such as an RTT channel or the UART, the output goes out
+ * in pieces of up to N characters so the stream is called only a few times.
+ */
+template <typename F, size_t N = 64>
+struct stream_output : output {
+    F func;
+    char buf[N];
+
+    explicit stream_output(F func) : output{buf, buf + N, put, 0}, func(func) {}
+
+    void flush() {
+        if (ptr != buf) func(buf, (size_t)(ptr - buf));
+        ptr = buf;
+    }
+
+    static void put(output *out, const char *data, size_t n) {
+        stream_output *self = static_cast<stream_output *>(out);
+
+        while (n) {
+            size_t chunk = (size_t)(self->end - self->ptr);
+
+            if (chunk > n) chunk = n;
+            for (size_t i = 0; i < chunk; i++) *self->ptr++ = data[i];
+            data += chunk;
+            n -= chunk;
+            if (self->ptr == self->end) self->flush();
+        }
+    }
+};
+
+enum : uint8_t {
+    FLAG_LEFT  = 1 << 0,
+    FLAG_ZERO  = 1 << 1,
+    FLAG_PLUS  = 1 << 2,
+    FLAG_SPACE = 1 << 3,
+    FLAG_ALT   = 1 << 4,
+};
+
+/** One conversion with the literal text in front of it. The last spec of a
+ * format string has conv 0 and holds only the trailing text.
+ */
+struct spec {
+    uint16_t lit_begin = 0;
+    uint16_t lit_len = 0;
+    char conv = 0;
+    uint8_t flags = 0;
+    uint8_t width = 0;
+    int8_t precision = -1;  // -1 if not given
+    uint8_t length = 0;     // Argument size in bytes from the length modifier, 0 if none
+};
+
+/** Type-erased argument.
+ */
+struct arg {
+    enum type_t : uint8_t { NONE, INT, UINT, FLOAT, FIXED, STR, PTR };
+
+    type_t type = NONE;
+    uint8_t size = 0;  // sizeof of an integer argument
+    uint8_t frac = 0;  // Fractional bits of a fixed argument
+    union {
+        int64_t i;
+        uint64_t u;
+        float f;
+        const char *s;
+        const void *p;
+    };
+
+    constexpr arg() : u(0) {}
+};
+
+namespace detail {
+
+template <typename T> struct is_fixed : std::false_type {};
+template <unsigned FRAC> struct is_fixed<fixed<FRAC>> : std::true_type {};
+
+template <unsigned FRAC>
+constexpr unsigned frac_of(const fixed<FRAC> &) { return FRAC; }
+
+template <typename T>
+constexpr arg::type_t type_of() {
+    using U = std::decay_t<T>;
+
+    if constexpr (std::is_same_v<U, bool>) return arg::UINT;
+    else if constexpr (std::is_enum_v<U>) return type_of<std::underlying_type_t<U>>();
+    else if constexpr (std::is_integral_v<U>) return std::is_signed_v<U> ? arg::INT : arg::UINT;
+    else if constexpr (std::is_floating_point_v<U>) return arg::FLOAT;
+    else if constexpr (is_fixed<U>::value) return arg::FIXED;
+    else if constexpr (std::is_same_v<U, char *> || std::is_same_v<U, const char *>) return arg::STR;
+    else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) return arg::PTR;
+    else return arg::NONE;
+}
+
+template <typename T>
+inline arg make_arg(const T &value) {
+    using U = std::decay_t<T>;
+    arg a;
+
+    a.type = type_of<T>();
+    if constexpr (std::is_enum_v<U>) {
+        a = make_arg(static_cast<std::underlying_type_t<U>>(value));
+    } else if constexpr (std::is_integral_v<U>) {
+        a.size = sizeof(U);
+        if constexpr (std::is_signed_v<U>) a.i = value; else a.u = value;
+    } else if constexpr (std::is_floating_point_v<U>) {
+        a.f = (float)value;
+    } else if constexpr (is_fixed<U>::value) {
+        a.i = value.raw;
+        a.frac = (uint8_t)frac_of(value);
+    } else if constexpr (std::is_same_v<U, char *> || std::is_same_v<U, const char *>) {
+        a.s = value;
+    } else {
+        a.p = (const void *)value;
+    }
+    return a;
+}
+
+/** Parse the literal text from pos up to the next conversion and the
+ * conversion itself, pos is left behind it. Returns false on a malformed
+ * conversion.
+ */
+constexpr bool parse_spec(const char *f, size_t &pos, spec &s) {
+    s = spec{};
+    s.lit_begin = (uint16_t)pos;
+    while (f[pos] && f[pos] != '%') pos++;
+    s.lit_len = (uint16_t)(pos - s.lit_begin);
+    if (!f[pos]) return true;
+    pos++;
+
+    for (;; pos++) {
+        if (f[pos] == '-') s.flags |= FLAG_LEFT;
+        else if (f[pos] == '0') s.flags |= FLAG_ZERO;
+        else if (f[pos] == '+') s.flags |= FLAG_PLUS;
+        else if (f[pos] == ' ') s.flags |= FLAG_SPACE;
+        else if (f[pos] == '#') s.flags |= FLAG_ALT;
+        else break;
+    }
+
+    unsigned width = 0;
+    while (f[pos] >= '0' && f[pos] <= '9') {
+        width = width * 10 + (f[pos++] - '0');
+        if (width > 255) return false;
+    }
+    s.width = (uint8_t)width;
+
+    if (f[pos] == '.') {
+        unsigned precision = 0;
+        pos++;
+        while (f[pos] >= '0' && f[pos] <= '9') {
+            precision = precision * 10 + (f[pos++] - '0');
+            if (precision > 127) return false;
+        }
+        s.precision = (int8_t)precision;
+    }
+
+    for (;; pos++) {
+        if (f[pos] == 'l') s.length = s.length ? sizeof(long long) : sizeof(long);
+        else if (f[pos] == 'j') s.length = sizeof(intmax_t);
+        else if (f[pos] == 'z') s.length = sizeof(size_t);
+        else if (f[pos] == 't') s.length = sizeof(ptrdiff_t);
+        else if (f[pos] != 'h') break;
+    }
+
+    switch (f[pos]) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+    case 'c': case 's': case 'p': case 'f': case '%':
+        s.conv = f[pos++];
+        return true;
+    default:
+        // Leave pos behind the unknown character so the caller can skip the conversion
+        if (f[pos]) pos++;
+        return false;
+    }
+}
+
+/** Number of specs in the format string (conversions plus the trailing
+ * text), 0 if the string is malformed.
+ */
+constexpr size_t count_specs(const char *f) {
+    size_t pos = 0;
+    size_t n = 0;
+    spec s;
+
+    do {
+        if (!parse_spec(f, pos, s)) return 0;
+        n++;
+    } while (s.conv);
+    return n;
+}
+
+constexpr bool accepts(char conv, arg::type_t type) {
+    switch (conv) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        return type == arg::INT || type == arg::UINT;
+    case 's': return type == arg::STR;
+    case 'p': return type == arg::PTR || type == arg::STR;
+    case 'f': return type == arg::FLOAT || type == arg::FIXED;
+    default: return false;
+    }
+}
+
+template <typename... Args>
+constexpr bool check_args(const char *f) {
+    constexpr arg::type_t types[] = {type_of<Args>()..., arg::NONE};
+    size_t pos = 0;
+    size_t n = 0;
+    spec s;
+
+    do {
+        if (!parse_spec(f, pos, s)) return false;
+        if (s.conv && s.conv != '%') {
+            if (n == sizeof...(Args) || !accepts(s.conv, types[n])) return false;
+            n++;
+        }
+    } while (s.conv);
+    return n == sizeof...(Args);
+}
+
+template <size_t N>
+struct spec_list {
+    spec s[N];
+};
+
+template <size_t N>
+constexpr spec_list<N> parse_all(const char *f) {
+    spec_list<N> list{};
+    size_t pos = 0;
+
+    for (size_t i = 0; i < N; i++) parse_spec(f, pos, list.s[i]);
+    return list;
+}
+
+/** Format string parsed at compile time, S is the type made by FMT().
+ */
+template <typename S>
+struct compiled {
+    static constexpr size_t count = count_specs(S::value());
+    static constexpr spec_list<count ? count : 1> specs = parse_all<count ? count : 1>(S::value());
+};
+
+inline void fill(output &out, char c, size_t n) {
+    static const char zeros[] = "0000000000000000";
+    static const char spaces[] = "                ";
+    const char *src = c == '0' ? zeros : spaces;
+
+    while (n) {
+        size_t chunk = n < 16 ? n : 16;
+
+        out.write(src, chunk);
+        n -= chunk;
+    }
+}
+
+/** Write prefix, zeros, body and trailing zeros padded to the field width.
+ */
+inline void put_padded(output &out, const spec &s, bool zero_pad, const char *prefix, size_t prefix_len,
+                       size_t zeros, const char *body, size_t body_len, size_t trail = 0) {
+    size_t len = prefix_len + zeros + body_len + trail;
+    size_t pad = s.width > len ? s.width - len : 0;
+    size_t lpad = 0;
+
+    if (s.flags & FLAG_LEFT) lpad = pad, pad = 0;
+    else if (zero_pad) zeros += pad, pad = 0;
+    if (pad) fill(out, ' ', pad);
+    if (prefix_len) out.write(prefix, prefix_len);
+    if (zeros) fill(out, '0', zeros);
+    if (body_len) out.write(body, body_len);
+    if (trail) fill(out, '0', trail);
+    if (lpad) fill(out, ' ', lpad);
+}
+
+/** Decimal digits of value, written backwards in front of end.
+ */
+inline char *put_dec(char *end, uint32_t value) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+/** 64-bit values are split into 9-digit groups so only the top part needs
+ * the library 64-bit division.
+ */
+inline char *put_dec(char *end, uint64_t value) {
+    while (value >> 32) {
+        uint64_t high = value / 1000000000u;
+        uint32_t low = (uint32_t)(value - high * 1000000000u);
+
+        for (int i = 0; i < 9; i++, low /= 10) *--end = (char)('0' + low % 10);
+        value = high;
+    }
+    return put_dec(end, (uint32_t)value);
+}
+
+/** Integer conversion of magnitude mag, U is uint32_t or uint64_t so the
+ * 32-bit run-time path does not carry the 64-bit arithmetic.
+ */
+template <typename U>
+inline void put_int(output &out, const spec &s, U mag, bool neg) {
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    char prefix[2];
+    size_t prefix_len = 0;
+
+    if (s.conv == 'x' || s.conv == 'X' || s.conv == 'p') {
+        const char *digits = s.conv == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+        bool alt = (s.flags & FLAG_ALT && mag) || s.conv == 'p';
+
+        if (mag || s.precision != 0) {
+            do {
+                *--p = digits[mag & 15];
+                mag >>= 4;
+            } while (mag);
+        }
+        if (alt) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = s.conv == 'X' ? 'X' : 'x';
+        }
+    } else if (s.conv == 'o') {
+        if (mag || s.precision != 0) {
+            do {
+                *--p = (char)('0' + (mag & 7));
+                mag >>= 3;
+            } while (mag);
+        }
+        // '#' makes the first digit a zero
+        if (s.flags & FLAG_ALT && (p == end || *p != '0')) *--p = '0';
+    } else {
+        if (mag || s.precision != 0) p = put_dec(end, mag);
+        if (s.conv == 'd' || s.conv == 'i') {
+            if (neg) prefix[prefix_len++] = '-';
+            else if (s.flags & FLAG_PLUS) prefix[prefix_len++] = '+';
+            else if (s.flags & FLAG_SPACE) prefix[prefix_len++] = ' ';
+        }
+    }
+
+    size_t len = (size_t)(end - p);
+    size_t zeros = s.precision > 0 && (size_t)s.precision > len ? s.precision - len : 0;
+
+    put_padded(out, s, (s.flags & FLAG_ZERO) && s.precision < 0, prefix, prefix_len, zeros, p, len);
+}
+
+/** Fixed notation of integer part ip (followed by extra zeros) and prec
+ * digits of fraction fp, the precision asked beyond 9 digits is zeros.
+ */
+inline void put_decimal(output &out, const spec &s, bool neg, uint64_t ip, uint32_t extra, uint32_t fp, int prec) {
+    size_t trail = s.precision > prec ? (size_t)(s.precision - prec) : 0;
+    char buf[64];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    char prefix = neg ? '-' : (s.flags & FLAG_PLUS) ? '+' : (s.flags & FLAG_SPACE) ? ' ' : 0;
+
+    for (int i = 0; i < prec; i++, fp /= 10) *--p = (char)('0' + fp % 10);
+    if (prec || s.flags & FLAG_ALT) *--p = '.';
+    while (extra--) *--p = '0';
+    p = put_dec(p, ip);
+
+    put_padded(out, s, s.flags & FLAG_ZERO, &prefix, prefix ? 1 : 0, 0, p, (size_t)(end - p), trail);
+}
+
+inline constexpr uint32_t pow10[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+inline void put_float(output &out, const spec &s, float v) {
+    int prec = s.precision < 0 ? 6 : s.precision > 9 ? 9 : s.precision;
+    bool neg = v < 0;
+    float a = neg ? -v : v;
+
+    if (a != a || a > 3.40282347e38f) {
+        const char *body = a != a ? "nan" : "inf";
+        char prefix = neg ? '-' : (s.flags & FLAG_PLUS) ? '+' : 0;
+
+        put_padded(out, s, false, &prefix, prefix ? 1 : 0, 0, body, 3);
+        return;
+    }
+
+    // Beyond 64 bits only the leading digits are significant anyway
+    uint32_t extra = 0;
+
+    while (a >= 1e18f) {
+        a /= 10;
+        extra++;
+    }
+
+    uint64_t ip = (uint64_t)a;
+    float x = (a - (float)ip) * pow10[prec];
+    uint32_t fp = (uint32_t)x;
+
+    // Round half to even as the C library does
+    if (x - fp > 0.5f || (x - fp == 0.5f && ((prec ? fp : ip) & 1))) fp++;
+    if (fp >= pow10[prec]) {
+        fp -= pow10[prec];
+        ip++;
+    }
+    put_decimal(out, s, neg, ip, extra, fp, prec);
+}
+
+inline void put_fixed(output &out, const spec &s, int32_t raw, unsigned frac) {
+    int prec = s.precision < 0 ? 6 : s.precision > 9 ? 9 : s.precision;
+    bool neg = raw < 0;
+    uint64_t mag = neg ? (uint64_t)(-(int64_t)raw) : (uint64_t)raw;
+    uint64_t ip = mag >> frac;
+    uint64_t fb = mag & ((1ull << frac) - 1);
+    uint32_t fp = frac ? (uint32_t)((fb * pow10[prec] + (1ull << (frac - 1))) >> frac) : 0;
+
+    if (fp >= pow10[prec]) {
+        fp -= pow10[prec];
+        ip++;
+    }
+    put_decimal(out, s, neg, ip, 0, fp, prec);
+}
+
+inline void put_char(output &out, const spec &s, char c) {
+    put_padded(out, s, false, 0, 0, 0, &c, 1);
+}
+
+inline void put_str(output &out, const spec &s, const char *str) {
+    size_t len = 0;
+
+    if (!str) str = "(null)";
+    while (str[len] && (s.precision < 0 || len < (size_t)s.precision)) len++;
+    put_padded(out, s, false, 0, 0, 0, str, len);
+}
+
+inline void put_arg(output &out, const spec &s, const arg &a) {
+    switch (s.conv) {
+    case 'c':
+        put_char(out, s, (char)a.u);
+        break;
+    case 's':
+        put_str(out, s, a.s);
+        break;
+    case 'p':
+        put_int(out, s, (uintptr_t)a.p, false);
+        break;
+    case 'f':
+        if (a.type == arg::FIXED) put_fixed(out, s, (int32_t)a.i, a.frac);
+        else put_float(out, s, a.f);
+        break;
+    default:
+        if (a.type == arg::INT) {
+            bool neg = a.i < 0 && (s.conv == 'd' || s.conv == 'i');
+
+            if (neg) put_int<uint64_t>(out, s, 0 - (uint64_t)a.i, true);
+            // A negative value printed unsigned wraps at its own width or the modifier's, as in C
+            else put_int<uint64_t>(out, s, a.size == 8 || s.length == 8 ? a.u : (uint32_t)a.i, false);
+        } else {
+            put_int<uint64_t>(out, s, a.u, false);
+        }
+        break;
+    }
+}
+
+/** Engine shared by all compile-time format strings.
+ */
+inline int format_specs(output &out, const char *f, const spec *specs, const arg *args) {
+    for (;; specs++) {
+        if (specs->lit_len) out.write(f + specs->lit_begin, specs->lit_len);
+        if (!specs->conv) break;
+        if (specs->conv == '%') out.write("%", 1);
+        else put_arg(out, *specs, *args++);
+    }
+    return (int)out.count;
+}
+
+} // namespace detail
+
+/** Format with a string parsed at run time, the argument types are taken
+ * from the conversions as in C. Unsupported conversions are copied to the
+ * output as they are and take no argument. Returns the output length.
+ */
+#ifdef FMT_RUNTIME_FULL
+inline int vformat(output &out, const char *f, va_list ap) {
+    size_t pos = 0;
+    spec s;
+
+    for (;;) {
+        bool ok = detail::parse_spec(f, pos, s);
+
+        if (s.lit_len) out.write(f + s.lit_begin, s.lit_len);
+        if (!ok) {
+            size_t conv_begin = s.lit_begin + s.lit_len;
+
+            out.write(f + conv_begin, pos - conv_begin);
+            continue;
+        }
+        if (!s.conv) break;
+
+        arg a;
+
+        switch (s.conv) {
+        case '%':
+            out.write("%", 1);
+            continue;
+        case 's':
+            a.type = arg::STR;
+            a.s = va_arg(ap, const char *);
+            break;
+        case 'p':
+            a.type = arg::PTR;
+            a.p = va_arg(ap, const void *);
+            break;
+        case 'f':
+            a.type = arg::FLOAT;
+            a.f = (float)va_arg(ap, double);
+            break;
+        case 'd': case 'i': case 'c':
+            a.type = arg::INT;
+            a.size = s.length == 8 ? 8 : 4;
+            a.i = s.length == 8 ? va_arg(ap, long long) : va_arg(ap, int);
+            break;
+        default:
+            a.type = arg::UINT;
+            a.size = s.length == 8 ? 8 : 4;
+            a.u = s.length == 8 ? va_arg(ap, unsigned long long) : va_arg(ap, unsigned int);
+            break;
+        }
+        detail::put_arg(out, s, a);
+    }
+    return (int)out.count;
+}
+#else
+inline int vformat(output &out, const char *f, va_list ap) {
+    size_t pos = 0;
+    spec s;
+
+    for (;;) {
+        bool ok = detail::parse_spec(f, pos, s);
+
+        if (s.lit_len) out.write(f + s.lit_begin, s.lit_len);
+        if (ok && !s.conv) break;
+
+        if (ok) {
+            if (s.conv == '%') {
+                out.write("%", 1);
+                continue;
+            }
+            if (s.conv == 's' || s.conv == 'p') {
+                const void *p = va_arg(ap, const void *);
+
+                if (s.conv == 's') detail::put_str(out, s, (const char *)p);
+                else detail::put_int(out, s, (uintptr_t)p, false);
+                continue;
+            }
+
+            // %f and 64-bit integers are not formatted here, their argument is skipped
+            if (s.conv == 'f') {
+                (void)va_arg(ap, double);
+            } else if (s.length == 8) {
+                (void)va_arg(ap, long long);
+            } else {
+                unsigned int v = va_arg(ap, unsigned int);
+                bool neg = (s.conv == 'd' || s.conv == 'i') && (int)v < 0;
+
+                if (s.conv == 'c') detail::put_char(out, s, (char)v);
+                else detail::put_int<uint32_t>(out, s, neg ? 0u - v : v, neg);
+                continue;
+            }
+        }
+
+        size_t conv_begin = s.lit_begin + s.lit_len;
+
+        out.write(f + conv_begin, pos - conv_begin);
+    }
+    return (int)out.count;
+}
+#endif
+
+/** Format into the sink out.
+ */
+template <typename S, typename... Args, if_format_string<S> = 0>
+inline int format_to(output &out, S, const Args &... args) {
+    using c = detail::compiled<S>;
+
+    static_assert(c::count != 0, "fmt: malformed format string");
+    static_assert(detail::check_args<Args...>(S::value()), "fmt: arguments do not match the format string");
+
+    const arg list[sizeof...(Args) + 1] = {detail::make_arg(args)...};
+
+    return detail::format_specs(out, S::value(), c::specs.s, list);
+}
+
+/** Format into buf with snprintf() semantics, returns the full output length.
+ */
+template <typename S, typename... Args, if_format_string<S> = 0>
+inline int format_to(char *buf, size_t size, S str, const Args &... args) {
+    buffer_output out(buf, size);
+    int n = format_to(out, str, args...);
+
+    out.finish();
+    return n;
+}
+
+template <size_t N, typename S, typename... Args, if_format_string<S> = 0>
+inline int format_to(char (&buf)[N], S str, const Args &... args) {
+    return format_to(buf, N, str, args...);
+}
+
+/** Format to a stream, func(const char *data, size_t size) is called with
+ * pieces of the output.
+ */
+template <typename F, typename S, typename... Args, if_format_string<S> = 0>
+inline int print_to(F func, S str, const Args &... args) {
+    stream_output<F> out(func);
+    int n = format_to(out, str, args...);
+
+    out.flush();
+    return n;
+}
+
+} // namespace fmt
+
+#endif // FORMAT_H
@@ -0,0 +1,261 @@
+#include <K1921VG015.h>
+#include <system_k1921vg015.h>
+#include <cstring>
+extern "C" {
+#include <mtimer.h>
+#include <swtimer.h>
+#include <irq_stats.h>
+#include <mem_stats.h>
+#include <perf.h>
+}
+#include "rtt_prof.h"
+#include "rtt_shell.h"
+#include "rtt_trace.h"
+#include "shell.h"
+#include "bench.h"
+
+/**
+ * @brief   Команда shell: использование стека и кучи.
+ *
+ */
+static int ShellMem( int, char *[] )
+{
+    // Проход до конца, чтобы пик был актуален.
+    while ( !mem_stats_scan() ) {}
+
+    mem_stats_t Stats = const_cast<const mem_stats_t &>( mem_stats );
+
+    rtt_shell_puts( "stack: peak " );
+    rtt_shell_put_dec( Stats.stack_peak );
+    rtt_shell_puts( " of " );
+    rtt_shell_put_dec( Stats.stack_size );
+    rtt_shell_puts( Stats.stack_overflow ? ", OVERFLOW\nheap: used " : "\nheap: used " );
+    rtt_shell_put_dec( Stats.heap_used );
+    rtt_shell_puts( ", peak " );
+    rtt_shell_put_dec( Stats.heap_peak );
+    rtt_shell_puts( " of " );
+    rtt_shell_put_dec( Stats.heap_size );
+    rtt_shell_puts( ", failed " );
+    rtt_shell_put_dec( Stats.heap_failed );
+    rtt_shell_puts( "\n" );
+
+    return 0;
+}
+
+#ifdef IRQ_STATS
+/**
+ * @brief   Команда shell: статистика прерываний в тактах (без printf, как и остальные команды).
+ *
+ */
+static int ShellIrq( int, char *[] )
+{
+    irq_stats_t Stats = const_cast<const irq_stats_t &>( irq_stats );
+
+    for ( uint32_t i = 0; i < IRQ_STATS_NUM; i++ )
+    {
+        const irq_stats_entry_t &Entry = Stats.irq[i];
+
+        if ( Entry.count == 0 ) continue;
+
+        rtt_shell_puts( i < IRQ_STATS_CORE( 0 ) ? "PLIC " : "CORE " );
+        rtt_shell_put_dec( i < IRQ_STATS_CORE( 0 ) ? i : i - IRQ_STATS_CORE( 0 ) );
+        rtt_shell_puts( ": count " );
+        rtt_shell_put_dec( Entry.count );
+        rtt_shell_puts( ", latency avg " );
+        rtt_shell_put_dec( ( uint32_t ) ( Entry.sum_latency / Entry.count ) );
+        rtt_shell_puts( " max " );
+        rtt_shell_put_dec( Entry.max_latency );
+        rtt_shell_puts( ", dispatch avg " );
+        rtt_shell_put_dec( ( uint32_t ) ( Entry.sum_dispatch / Entry.count ) );
+        rtt_shell_puts( " max " );
+        rtt_shell_put_dec( Entry.max_dispatch );
+        rtt_shell_puts( ", duration avg " );
+        rtt_shell_put_dec( ( uint32_t ) ( Entry.sum_duration / Entry.count ) );
+        rtt_shell_puts( " max " );
+        rtt_shell_put_dec( Entry.max_duration );
+        rtt_shell_puts( "\n" );
+    }
+
+    rtt_shell_puts( "max nesting depth " );
+    rtt_shell_put_dec( Stats.max_depth );
+    rtt_shell_puts( "\n" );
+
+    return 0;
+}
+#endif // IRQ_STATS
+
+#ifdef MTIMER_SLEEP_STATS
+/**
+ * @brief   Команда shell: статистика задержек sleep()/usleep() в тактах mtime.
+ *
+ */
+static int ShellSleep( int, char *[] )
+{
+    mtimer_sleep_stats_t Stats = const_cast<const mtimer_sleep_stats_t &>( mtimer_sleep_stats );
+
+    rtt_shell_puts( "sleep: count " );
+    rtt_shell_put_dec( Stats.count );
+    rtt_shell_puts( ", wakeups " );
+    rtt_shell_put_dec( Stats.wakeups );
+    rtt_shell_puts( ", latency min " );
+    rtt_shell_put_dec( Stats.min_latency );
+    rtt_shell_puts( " max " );
+    rtt_shell_put_dec( Stats.max_latency );
+    rtt_shell_puts( " last " );
+    rtt_shell_put_dec( Stats.last_latency );
+    rtt_shell_puts( "\n" );
+
+    return 0;
+}
+#endif // MTIMER_SLEEP_STATS
+
+#ifdef SWTIMER_STATS
+/**
+ * @brief   Команда shell: статистика программных таймеров.
+ *
+ */
+static int ShellSwTimer( int, char *[] )
+{
+    swtimer_stats_t Stats = const_cast<const swtimer_stats_t &>( swtimer_stats );
+
+    rtt_shell_puts( "swtimer: active " );
+    rtt_shell_put_dec( Stats.active );
+    rtt_shell_puts( ", dispatches " );
+    rtt_shell_put_dec( Stats.dispatches );
+    rtt_shell_puts( ", expired " );
+    rtt_shell_put_dec( Stats.expired );
+    rtt_shell_puts( ", cascaded " );
+    rtt_shell_put_dec( Stats.cascaded );
+    rtt_shell_puts( ", max dispatch " );
+    rtt_shell_put_dec( Stats.max_cycles );
+    rtt_shell_puts( " cycles\n" );
+
+    return 0;
+}
+#endif // SWTIMER_STATS
+
+/**
+ * @brief   Команда shell: prof start [Гц] | prof stop | prof (статистика).
+ *
+ */
+static int ShellProf( int argc, char *argv[] )
+{
+    uint32_t Rate = 0;
+
+    if ( argc > 1 && strcmp( argv[1], "start" ) == 0 )
+    {
+        if ( argc > 2 && !rtt_shell_parse_u32( argv[2], &Rate ) ) return -1;
+
+        rtt_prof_stats_reset();
+        rtt_prof_start( Rate );
+    }
+    else if ( argc > 1 && strcmp( argv[1], "stop" ) == 0 )
+    {
+        rtt_prof_stop();
+    }
+    else if ( argc > 1 )
+    {
+        return -1;
+    }
+
+    rtt_prof_stats_t Stats = const_cast<const rtt_prof_stats_t &>( rtt_prof_stats );
+
+    rtt_shell_puts( "prof: samples " );
+    rtt_shell_put_dec( Stats.samples );
+    rtt_shell_puts( ", dropped " );
+    rtt_shell_put_dec( Stats.dropped );
+    rtt_shell_puts( ", max " );
+    rtt_shell_put_dec( Stats.max_cycles );
+    rtt_shell_puts( " cycles per sample\n" );
+
+    return 0;
+}
+
+/**
+ * @brief   Команда shell: запуск и остановка трассы событий.
+ *
+ */
+static int ShellTrace( int argc, char *argv[] )
+{
+    if ( argc > 1 && strcmp( argv[1], "start" ) == 0 )
+    {
+        rtt_trace_start();
+    }
+    else if ( argc > 1 && strcmp( argv[1], "stop" ) == 0 )
+    {
+        rtt_trace_stop();
+    }
+    else if ( argc > 1 )
+    {
+        return -1;
+    }
+
+    trace_stats_t Stats = const_cast<const trace_stats_t &>( trace_stats );
+
+    rtt_shell_puts( "trace: events " );
+    rtt_shell_put_dec( Stats.events );
+    rtt_shell_puts( ", lost " );
+    rtt_shell_put_dec( Stats.lost );
+    rtt_shell_puts( "\n" );
+
+    return 0;
+}
+
+const char *const PerfLevelNames[PERF_LEVEL_NUM] = { "low", "mid", "high" };
+
+/**
+ * @brief   Команда shell: perf [low|mid|high] - переключение уровня производительности.
+ *
+ */
+static int ShellPerf( int argc, char *argv[] )
+{
+    if ( argc > 2 ) return -1;
+
+    if ( argc == 2 )
+    {
+        int Level = PERF_LEVEL_NUM;
+
+        while ( --Level >= 0 && strcmp( argv[1], PerfLevelNames[Level] ) != 0 )
+        {
+        }
+
+        if ( Level < 0 || perf_set_level( ( perf_level_t ) Level ) != 0 ) return -1;
+    }
+
+    rtt_shell_puts( "perf: " );
+    rtt_shell_puts( PerfLevelNames[perf_get_level()] );
+    rtt_shell_puts( ", SYSCLK " );
+    rtt_shell_put_dec( SystemCoreClock );
+    rtt_shell_puts( " Hz, switches " );
+    rtt_shell_put_dec( perf_stats.switches );
+    rtt_shell_puts( ", max " );
+    rtt_shell_put_dec( perf_stats.max_ns );
+    rtt_shell_puts( " ns\n" );
+
+    return 0;
+}
+
+static const rtt_shell_command_t ShellCommands[] =
+{
+#ifdef IRQ_STATS
+    { "irq",     "IRQ statistics", ShellIrq },
+#endif // IRQ_STATS
+    { "mem",     "stack and heap usage", ShellMem },
+#ifdef MTIMER_SLEEP_STATS
+    { "sleep",   "sleep() latency statistics", ShellSleep },
+#endif // MTIMER_SLEEP_STATS
+#ifdef SWTIMER_STATS
+    { "swtimer", "software timer statistics", ShellSwTimer },
+#endif // SWTIMER_STATS
+    { "prof",    "[start [hz] | stop] profiler control", ShellProf },
+    { "trace",   "[start | stop] event trace control", ShellTrace },
+    { "perf",    "[low | mid | high] performance level", ShellPerf },
+#ifdef RTT_BENCH
+    { "bench",   "<sleep|irq|ramfunc|flash|perf|swtimer|write|copy|log|format|speed|prof|trace> run a benchmark", BenchShell },
+#endif // RTT_BENCH
+};
+
+void ShellInit()
+{
+    rtt_shell_init( ShellCommands, sizeof( ShellCommands ) / sizeof( ShellCommands[0] ) );
+}
@@ -0,0 +1,20 @@
+#ifndef _SHELL_H_
+#define _SHELL_H_
+
+#include <stdint.h>
+extern "C" {
+#include <perf.h>
+}
+
+// Команды приложения для терминала RTT, печатают без printf (rtt_shell_puts()).
+
+// Имена уровней производительности для команды perf и замеров (bench.cpp).
+extern const char *const PerfLevelNames[PERF_LEVEL_NUM];
+
+/**
+ * @brief   Подключает команды приложения к shell терминала RTT и выводит приглашение.
+ *
+ */
+void ShellInit();
+
+#endif // _SHELL_H_
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+Декодер отложенного бинарного лога RTT (см. RTT/rtt_log.h).
+
+Цель пишет в свой канал RTT только записи из 32-битных слов:
+    uint32_t Header;     // ID формата | (число аргументов << 28)
+    uint32_t Time;       // Младшее слово mtime
+    uint32_t Args[N];    // Аргументы как есть
+
+ID формата - адрес строки в незагружаемой секции .rtt_log_fmt ELF-файла.
+Строки %s ищутся по адресу в загружаемых секциях того же ELF.
+
+Поток канала можно снять, например, так:
+    JLinkRTTLogger -Device K1921VG015 -If JTAG -Speed 4000 -RTTChannel 2 log.bin
+
+Примеры:
+    python rtt_log_decode.py build/Release/rtt-default.elf log.bin
+    JLinkRTTLogger ... /dev/stdout | python rtt_log_decode.py rtt-default.elf -
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FMT_SECTION = ".rtt_log_fmt"
+
+SHT_NOBITS = 8
+SHF_ALLOC = 2
+
+MTIME_FREQ_HZ = 50000000
+
+# Спецификатор printf: флаги, ширина, точность, модификаторы длины, преобразование.
+SPEC = re.compile(r"%([-+ #0]*)(\d+)?(?:\.(\d+))?(hh|h|ll|l|j|z|t)?([diuxXocspn%])")
+
+
+class Elf:
+    """Секции ELF32 LE: строки форматов и загружаемые данные для %s."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("поддерживается только ELF32 Little Endian")
+
+        e_shoff, = struct.unpack_from("<I", data, 0x20)
+        e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+        headers = [struct.unpack_from("<IIIIIIIIII", data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+        names = headers[e_shstrndx]
+
+        self.formats = None
+        self.sections = []
+
+        for sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size, *_ in headers:
+            name = data[names[4] + sh_name:data.index(b"\0", names[4] + sh_name)].decode()
+            content = data[sh_offset:sh_offset + sh_size] if sh_type != SHT_NOBITS else b""
+
+            if name == FMT_SECTION:
+                self.formats = (sh_addr, content)
+            elif sh_flags & SHF_ALLOC and content:
+                self.sections.append((sh_addr, content))
+
+        if self.formats is None:
+            raise ValueError("в ELF нет секции " + FMT_SECTION)
+
+    @staticmethod
+    def _string(base, content, addr):
+        offset = addr - base
+        end = content.find(b"\0", offset)
+        return content[offset:end if end >= 0 else len(content)].decode(errors="replace")
+
+    def format(self, fmt_id):
+        base, content = self.formats
+
+        if not base <= fmt_id < base + len(content):
+            return None
+
+        return self._string(base, content, fmt_id)
+
+    def string(self, addr):
+        for base, content in self.sections:
+            if base <= addr < base + len(content):
+                return self._string(base, content, addr)
+
+        return "<0x%08X>" % addr
+
+
+def render(elf, fmt, args):
+    """Подставляет аргументы в строку формата printf."""
+    args = iter(args)
+
+    def replace(m):
+        flags, width, precision, _, conv = m.groups()
+
+        if conv == "%":
+            return "%"
+
+        value = next(args, 0)
+
+        if conv in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+        elif conv == "c":
+            value = chr(value & 0xFF)
+        elif conv == "s":
+            value = elf.string(value)
+        elif conv == "p":
+            conv, flags = "x", flags + "#"
+        elif conv == "n":
+            return ""
+
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "") + ("d" if conv == "u" else conv)
+        return spec % value
+
+    return SPEC.sub(replace, fmt)
+
+
+def records(stream):
+    """Разбирает поток на записи (header, time, args)."""
+    buf = b""
+
+    while True:
+        chunk = stream.read(4096)
+
+        if not chunk:
+            break
+
+        buf += chunk
+        pos = 0
+
+        while len(buf) - pos >= 8:
+            header, time = struct.unpack_from("<II", buf, pos)
+            count = header >> 28
+            size = 8 + 4 * count
+
+            if len(buf) - pos < size:
+                break
+
+            yield header & 0x0FFFFFFF, time, struct.unpack_from("<%dI" % count, buf, pos + 8)
+            pos += size
+
+        buf = buf[pos:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Декодер бинарного лога RTT")
+    parser.add_argument("elf", help="ELF-файл прошивки")
+    parser.add_argument("log", help="Поток канала RTT ('-' для stdin)")
+    parser.add_argument("--mtime-hz", type=int, default=MTIME_FREQ_HZ, help="Частота mtime, Гц (по умолчанию %(default)s)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    stream = sys.stdin.buffer if args.log == "-" else open(args.log, "rb")
+
+    # mtime в записи 32-битный: восстанавливаем старшую часть по переполнениям.
+    last = None
+    high = 0
+
+    for fmt_id, time, values in records(stream):
+        if last is not None and time < last:
+            high += 1 << 32
+
+        last = time
+        seconds = (high + time) / args.mtime_hz
+        fmt = elf.format(fmt_id)
+
+        if fmt is None:
+            text = "<unknown format 0x%07X>" % fmt_id
+        else:
+            text = render(elf, fmt, values).rstrip("\n")
+
+        print("[%12.6f] %s" % (seconds, text), flush=True)
+
+
+if __name__ == "__main__":
+    main()
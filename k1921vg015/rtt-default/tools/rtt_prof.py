@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Агрегатор выборок профилировщика RTT (см. RTT/rtt_prof.h).
+
+Цель пишет в свой канал RTT значения mepc по 4 байта (LE). Выборки
+сопоставляются с функциями из таблицы символов ELF.
+
+Поток канала можно снять, например, так:
+    JLinkRTTLogger -Device K1921VG015 -If JTAG -Speed 4000 -RTTChannel 3 prof.bin
+
+Вывод:
+    - плоский профиль: число выборок, доля и имя функции;
+    - --folded: строки "функция число" для flamegraph.pl / speedscope.
+      Стек вызовов на цели не раскручивается, поэтому у каждой выборки
+      один кадр; с --sections добавляется кадр секции (.text, .text.startup, ...).
+
+Примеры:
+    python rtt_prof.py build/Release/rtt-default.elf prof.bin
+    python rtt_prof.py rtt-default.elf prof.bin --folded prof.folded
+    flamegraph.pl prof.folded > prof.svg
+"""
+
+import argparse
+import bisect
+import collections
+import struct
+import sys
+
+SHT_SYMTAB = 2
+SHN_UNDEF = 0
+STT_FUNC = 2
+SHF_EXECINSTR = 4
+
+
+class Symbols:
+    """Функции и исполняемые секции ELF32 LE."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("поддерживается только ELF32 Little Endian")
+
+        e_shoff, = struct.unpack_from("<I", data, 0x20)
+        e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+        headers = [struct.unpack_from("<IIIIIIIIII", data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+        names = headers[e_shstrndx][4]
+
+        def cstr(offset):
+            return data[offset:data.index(b"\0", offset)].decode(errors="replace")
+
+        self.sections = []
+        functions = {}
+
+        for sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size, sh_link, _, _, sh_entsize in headers:
+            if sh_flags & SHF_EXECINSTR and sh_size:
+                self.sections.append((sh_addr, sh_addr + sh_size, cstr(names + sh_name)))
+
+            if sh_type != SHT_SYMTAB:
+                continue
+
+            strtab = headers[sh_link][4]
+
+            for offset in range(sh_offset, sh_offset + sh_size, sh_entsize):
+                st_name, st_value, st_size, st_info, _, st_shndx = struct.unpack_from("<IIIBBH", data, offset)
+
+                if st_info & 0xF == STT_FUNC and st_name and st_shndx != SHN_UNDEF:
+                    # Бит 0 адреса в RISC-V не используется, но на всякий случай сбрасываем.
+                    functions[st_value & ~1] = (st_size, cstr(strtab + st_name))
+
+        self.starts = sorted(functions)
+        self.functions = [functions[a] for a in self.starts]
+
+    def function(self, pc):
+        i = bisect.bisect_right(self.starts, pc) - 1
+
+        if i >= 0:
+            size, name = self.functions[i]
+
+            # Символы без размера (из ассемблера) покрывают всё до следующей функции.
+            if pc < self.starts[i] + size or size == 0:
+                return name
+
+        return "0x%08X" % pc
+
+    def section(self, pc):
+        for start, end, name in self.sections:
+            if start <= pc < end:
+                return name
+
+        return "?"
+
+
+def samples(stream):
+    """Значения mepc из потока канала."""
+    tail = b""
+
+    while True:
+        chunk = stream.read(4096)
+
+        if not chunk:
+            break
+
+        chunk = tail + chunk
+        whole = len(chunk) & ~3
+        yield from struct.unpack_from("<%dI" % (whole // 4), chunk)
+        tail = chunk[whole:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Профиль по выборкам mepc из RTT")
+    parser.add_argument("elf", help="ELF-файл прошивки")
+    parser.add_argument("samples", help="Поток канала RTT ('-' для stdin)")
+    parser.add_argument("--top", type=int, default=30, help="Число строк плоского профиля (по умолчанию %(default)s)")
+    parser.add_argument("--folded", help="Файл для свёрнутых стеков (flamegraph.pl)")
+    parser.add_argument("--sections", action="store_true", help="Добавить кадр секции в свёрнутые стеки")
+    args = parser.parse_args()
+
+    symbols = Symbols(args.elf)
+    stream = sys.stdin.buffer if args.samples == "-" else open(args.samples, "rb")
+
+    counts = collections.Counter()
+    stacks = collections.Counter()
+
+    for pc in samples(stream):
+        name = symbols.function(pc)
+        counts[name] += 1
+        stacks[(symbols.section(pc), name) if args.sections else (name,)] += 1
+
+    total = sum(counts.values())
+
+    if not total:
+        print("нет выборок")
+        return
+
+    print("%10s %7s  %s" % ("samples", "%", "function"))
+
+    for name, count in counts.most_common(args.top):
+        print("%10d %6.2f%%  %s" % (count, 100.0 * count / total, name))
+
+    print("%10d %6.2f%%  total" % (total, 100.0))
+
+    if args.folded:
+        with open(args.folded, "w") as f:
+            for stack, count in sorted(stacks.items()):
+                f.write("%s %d\n" % (";".join(stack), count))
+
+
+if __name__ == "__main__":
+    main()
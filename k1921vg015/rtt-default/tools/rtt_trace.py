@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+Преобразователь трассы событий RTT (см. platform/.../include/trace.h,
+RTT/rtt_trace.h) в формат Chrome trace JSON.
+
+Событие: байт заголовка (номер события, бит 7 - есть полезная нагрузка),
+приращение mtime от предыдущего события (LEB128) и полезная нагрузка (LEB128).
+mtime считает SYSCLK, поэтому смена частоты (perf_set_level()) записывается
+событием FREQ, и каждое приращение переводится в мкс по частоте, действовавшей
+на его интервале.
+
+Поток канала можно снять, например, так:
+    JLinkRTTLogger -Device K1921VG015 -If JTAG -Speed 4000 -RTTChannel 4 trace.bin
+
+Результат открывается в chrome://tracing или https://ui.perfetto.dev:
+    - поток "irq": обработчики прерываний и вложенные в них callback'и swtimer;
+    - поток "main": sleep(), wfi и пользовательские отрезки trace_span_*();
+    - метки trace_mark(), пользовательские события и потери - мгновенные события.
+
+Примеры:
+    python rtt_trace.py trace.bin trace.json
+    python rtt_trace.py trace.bin trace.json --elf build/Release/rtt-default.elf
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+EV_START = 0
+EV_OVERFLOW = 1
+EV_IRQ_ENTER = 2
+EV_IRQ_EXIT = 3
+EV_TIMER_ENTER = 4
+EV_TIMER_EXIT = 5
+EV_SLEEP_BEGIN = 6
+EV_SLEEP_END = 7
+EV_WFI_ENTER = 8
+EV_WFI_EXIT = 9
+EV_MARK = 10
+EV_SPAN_BEGIN = 11
+EV_SPAN_END = 12
+EV_FREQ = 13
+EV_USER = 32
+
+PAYLOAD = 0x80
+
+# Индексы IRQ_STATS_CORE(): 32 + код прерывания в mcause.
+CORE_IRQS = {32 + 3: "MSI", 32 + 7: "MTI", 32 + 11: "MEI"}
+
+TID_MAIN = 1
+TID_IRQ = 2
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "platform", "Device", "K1921VG015", "include", "K1921VG015.h")
+
+
+def varint(data, pos):
+    """Беззнаковое LEB128 с позиции pos, возвращает (значение, новая позиция)."""
+    value = 0
+    shift = 0
+
+    while True:
+        if pos >= len(data):
+            raise EOFError
+
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+
+        if not byte & 0x80:
+            return value, pos
+
+
+def events(data):
+    """События потока: (приращение mtime, номер, полезная нагрузка или None)."""
+    pos = 0
+
+    while pos < len(data):
+        head = data[pos]
+
+        try:
+            delta, end = varint(data, pos + 1)
+            payload = None
+
+            if head & PAYLOAD:
+                payload, end = varint(data, end)
+        except EOFError:
+            # Обрезанное последнее событие.
+            break
+
+        pos = end
+        yield delta, head & 0x7F, payload
+
+
+def irq_names(path):
+    """Имена источников PLIC из перечисления Plic_IsrVect_TypeDef."""
+    names = dict(CORE_IRQS)
+
+    if path and os.path.exists(path):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            for name, number in re.findall(r"IsrVect_IRQ_(\w+)\s*=\s*(\d+)", f.read()):
+                names[int(number)] = name
+
+    return names
+
+
+def convert(data, freq, irqs, symbols):
+    """Список событий Chrome trace (время в мкс)."""
+    out = [
+        {"ph": "M", "pid": 1, "tid": TID_MAIN, "name": "thread_name", "args": {"name": "main"}},
+        {"ph": "M", "pid": 1, "tid": TID_IRQ, "name": "thread_name", "args": {"name": "irq"}},
+    ]
+    timers = []
+    time = 0.0
+
+    def add(ph, tid, name, time, **extra):
+        event = {"ph": ph, "pid": 1, "tid": tid, "name": name, "ts": time}
+        event.update(extra)
+        out.append(event)
+
+    def function(address):
+        return symbols.function(address) if symbols else "0x%08X" % address
+
+    for delta, event, payload in events(data):
+        # Приращение прошло на частоте, действовавшей до этого события.
+        time += delta * 1e6 / freq
+
+        if event == EV_START:
+            # Частота mtime; события до START (хвост прошлой записи) считаются с прежней.
+            freq = payload or freq
+            add("i", TID_MAIN, "trace start", time, s="g")
+        elif event == EV_FREQ:
+            freq = payload or freq
+            add("i", TID_MAIN, "mtime %g MHz" % (freq / 1e6), time, s="g")
+        elif event == EV_OVERFLOW:
+            add("i", TID_MAIN, "lost %d events" % payload, time, s="g")
+        elif event == EV_IRQ_ENTER:
+            add("B", TID_IRQ, irqs.get(payload, "IRQ %d" % payload), time)
+        elif event == EV_IRQ_EXIT:
+            add("E", TID_IRQ, irqs.get(payload, "IRQ %d" % payload), time)
+        elif event == EV_TIMER_ENTER:
+            timers.append(function(payload))
+            add("B", TID_IRQ, timers[-1], time, cat="swtimer")
+        elif event == EV_TIMER_EXIT:
+            add("E", TID_IRQ, timers.pop() if timers else "swtimer", time, cat="swtimer")
+        elif event == EV_SLEEP_BEGIN:
+            add("B", TID_MAIN, "sleep", time, args={"us": round(payload * 1e6 / freq, 3)})
+        elif event == EV_SLEEP_END:
+            add("E", TID_MAIN, "sleep", time)
+        elif event == EV_WFI_ENTER:
+            add("B", TID_MAIN, "wfi", time)
+        elif event == EV_WFI_EXIT:
+            add("E", TID_MAIN, "wfi", time)
+        elif event == EV_MARK:
+            add("i", TID_MAIN, "mark", time, s="t", args={"value": payload})
+        elif event == EV_SPAN_BEGIN:
+            add("B", TID_MAIN, "span %d" % payload, time)
+        elif event == EV_SPAN_END:
+            add("E", TID_MAIN, "span %d" % payload, time)
+        else:
+            add("i", TID_MAIN, "user %d" % event, time, s="t", args={"value": payload})
+
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Трасса событий RTT в Chrome trace JSON")
+    parser.add_argument("trace", help="Поток канала RTT ('-' для stdin)")
+    parser.add_argument("output", help="Файл JSON ('-' для stdout)")
+    parser.add_argument("--elf", help="ELF-файл прошивки для имён callback'ов swtimer")
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="K1921VG015.h для имён прерываний")
+    parser.add_argument("--freq", type=float, default=50e6,
+                        help="Частота mtime, если в потоке нет события START (по умолчанию %(default)g)")
+    args = parser.parse_args()
+
+    data = sys.stdin.buffer.read() if args.trace == "-" else open(args.trace, "rb").read()
+    symbols = None
+
+    if args.elf:
+        from rtt_prof import Symbols
+        symbols = Symbols(args.elf)
+
+    trace = convert(data, args.freq, irq_names(args.header), symbols)
+    text = json.dumps({"traceEvents": trace, "displayTimeUnit": "ns"}, ensure_ascii=False)
+
+    if args.output == "-":
+        print(text)
+    else:
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(text)
+
+    print("%d событий" % (len(trace) - 2), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
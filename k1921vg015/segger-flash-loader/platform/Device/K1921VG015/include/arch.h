@@ -66,6 +66,11 @@
 #define PLF_TRAP_STACK 0
 #endif // PLF_TRAP_STACK
 
+// interrupt-only trap fast path: save caller-saved regs only (not used with trap stack)
+#ifndef PLF_TRAP_FAST_IRQ
+#define PLF_TRAP_FAST_IRQ (!PLF_TRAP_STACK)
+#endif // PLF_TRAP_FAST_IRQ
+
 #ifndef PLF_ATOMIC_SUPPORTED
 #ifdef __riscv_atomic
 #define PLF_ATOMIC_SUPPORTED 1
@@ -113,6 +118,16 @@
 // mstatus bits
 #define MSTATUS_MIE   (1 << 3)
 
+// hot code and data run from RAM: copied from flash to REGION_RAMFUNC at boot (see the linker script)
+#ifdef __ASSEMBLER__
+#define __RAMFUNC   ".ramfunc","ax",@progbits
+#define __FASTDATA  ".fastdata","aw",@progbits
+#else // __ASSEMBLER__
+// noinline: a copy inlined into a flash caller would run from flash again
+#define __ramfunc   __attribute__((__section__(".ramfunc"), __noinline__))
+#define __fastdata  __attribute__((__section__(".fastdata")))
+#endif // __ASSEMBLER__
+
 #ifndef __ASSEMBLER__
 
 #include <stdint.h>
@@ -0,0 +1,236 @@
+#ifndef CLK_CONFIG_H
+#define CLK_CONFIG_H
+
+#include <stdint.h>
+
+/** Compile-time clock tree configuration.
+ *
+ * The system and USB PLLs share one layout:
+ *   FOUTVCO = HSE / REFDIV * (FBDIV + FRAC / 2^24)
+ *   FOUT0   = FOUTVCO / (PD0A * PD0B), FOUT1 = FOUTVCO / (PD1A * PD1B)
+ * with PDxA in 1..8 and PDxB in 1..64 (the register fields hold the value
+ * minus one). The PLL_* step macros below pick the dividers for a target
+ * FOUT0/FOUT1 without a search loop, so they are integer constant expressions
+ * in C and C++ alike:
+ * - REFDIV brings the reference down to 10..20 MHz;
+ * - for PD0A = 8..1 PD0B takes the largest total divider the VCO range
+ *   allows, the first candidate with an integer FBDIV wins, otherwise PD0A
+ *   = 8 is used with the fractional divider (DSMEN);
+ * - FOUT1 must divide FOUTVCO exactly.
+ *
+ * The system PLL is solved from HSECLK_VAL, SYSCLK_PLL_HZ and SYSCLK_PLL1_HZ
+ * into the PLL_SYS_* constants (PLL_PROFILE(), perf.c solves its levels the
+ * same way), and SYSTEM_CORE_CLOCK_HZ is the clock selected
+ * by ClkInit() (SYSCLK_PLL | SYSCLK_HSE | SYSCLK_HSI | SYSCLK_LSI). An
+ * impossible combination stops the build. C++ code may solve other targets,
+ * e.g. the 48 MHz USB clock, with the constexpr pll_solve().
+ *
+ * FRAC has 24 bits, so a fractional solution is rounded down: 49999999 Hz
+ * from 16 MHz gives 49999998 Hz. The frequencies actually reached are
+ * PLL_SYS_OUT0_HZ/PLL_SYS_OUT1_HZ (pll_config_t.out0_hz/out1_hz), and the
+ * build fails when they differ from the targets by more than
+ * SYSCLK_PLL_TOLERANCE_HZ, which is 0 by default.
+ *
+ * With FRAC != 0 DSMEN is set and DACEN is left at 0. Fractional mode has
+ * not been verified on hardware, only the integer solutions have.
+ */
+
+#ifndef HSECLK_VAL
+#define HSECLK_VAL 0
+#endif
+#ifndef HSICLK_VAL
+    #define HSICLK_VAL 1000000
+#endif
+#ifndef LSICLK_VAL
+    #define LSICLK_VAL 32768
+#endif
+
+#ifndef SYSCLK_PLL_HZ
+#define SYSCLK_PLL_HZ 50000000
+#endif
+#ifndef SYSCLK_PLL1_HZ
+#define SYSCLK_PLL1_HZ (SYSCLK_PLL_HZ / 2)
+#endif
+#ifndef SYSCLK_PLL_TOLERANCE_HZ
+#define SYSCLK_PLL_TOLERANCE_HZ 0
+#endif
+
+#define PLL_PFD_MIN_HZ      10000000ULL
+#define PLL_VCO_MIN_HZ      200000000ULL
+#define PLL_VCO_MAX_HZ      1600000000ULL
+#define PLL_FBDIV_MIN       16
+#define PLL_FBDIV_MAX       160
+#define PLL_REFDIV_MAX      63
+#define PLL_PDA_MAX         8
+#define PLL_PDB_MAX         64
+#define PLL_FRAC_BITS       24
+
+#define PLL_MIN(A, B)       ((A) < (B) ? (A) : (B))
+#define PLL_ABS_DIFF(A, B)  ((A) < (B) ? (B) - (A) : (A) - (B))
+
+/** Reference divider for an HSE frequency.
+ */
+#define PLL_REFDIV(HSE) \
+    ((HSE) / PLL_PFD_MIN_HZ ? (HSE) / PLL_PFD_MIN_HZ : 1)
+
+/** Largest PDxB for a given PDxA that keeps FOUTVCO = OUT * PDxA * PDxB in range.
+ */
+#define PLL_PDB_FOR(OUT, A) \
+    ((OUT) ? PLL_MIN(PLL_VCO_MAX_HZ / (OUT) / (A), PLL_PDB_MAX) : 0)
+
+#define PLL_VCO_FOR(OUT, A) \
+    ((uint64_t)(OUT) * (A) * PLL_PDB_FOR(OUT, A))
+
+#define PLL_FBDIV(HSE, REFDIV, VCO) \
+    ((uint64_t)(VCO) * (REFDIV) / (HSE))
+
+#define PLL_FRAC(HSE, REFDIV, VCO) \
+    ((((uint64_t)(VCO) * (REFDIV) % (HSE)) << PLL_FRAC_BITS) / (HSE))
+
+/** The candidate PD0A gives an integer FBDIV within range.
+ */
+#define PLL_INT_FOR(HSE, REFDIV, OUT, A)                                                 \
+    (PLL_VCO_FOR(OUT, A) >= PLL_VCO_MIN_HZ &&                                            \
+     PLL_FRAC(HSE, REFDIV, PLL_VCO_FOR(OUT, A)) == 0 &&                                  \
+     PLL_FBDIV(HSE, REFDIV, PLL_VCO_FOR(OUT, A)) >= PLL_FBDIV_MIN &&                     \
+     PLL_FBDIV(HSE, REFDIV, PLL_VCO_FOR(OUT, A)) <= PLL_FBDIV_MAX)
+
+#define PLL_PD0A(HSE, REFDIV, OUT)                                                       \
+    (PLL_INT_FOR(HSE, REFDIV, OUT, 8) ? 8 : PLL_INT_FOR(HSE, REFDIV, OUT, 7) ? 7 :       \
+     PLL_INT_FOR(HSE, REFDIV, OUT, 6) ? 6 : PLL_INT_FOR(HSE, REFDIV, OUT, 5) ? 5 :       \
+     PLL_INT_FOR(HSE, REFDIV, OUT, 4) ? 4 : PLL_INT_FOR(HSE, REFDIV, OUT, 3) ? 3 :       \
+     PLL_INT_FOR(HSE, REFDIV, OUT, 2) ? 2 : PLL_INT_FOR(HSE, REFDIV, OUT, 1) ? 1 :       \
+     PLL_PDA_MAX)
+
+/** PDxA for a total divider D, 0 if D cannot be split into PDxA * PDxB.
+ */
+#define PLL_PDA_FITS(D, A)  ((D) % (A) == 0 && (D) / (A) <= PLL_PDB_MAX)
+#define PLL_PDA_SPLIT(D)                                                                 \
+    ((D) == 0 ? 0 : PLL_PDA_FITS(D, 8) ? 8 : PLL_PDA_FITS(D, 7) ? 7 :                    \
+     PLL_PDA_FITS(D, 6) ? 6 : PLL_PDA_FITS(D, 5) ? 5 : PLL_PDA_FITS(D, 4) ? 4 :          \
+     PLL_PDA_FITS(D, 3) ? 3 : PLL_PDA_FITS(D, 2) ? 2 : PLL_PDA_FITS(D, 1) ? 1 : 0)
+
+/** FOUT1 divider, the slowest output when FOUT1 is not used (OUT1 = 0).
+ */
+#define PLL_DIV1(VCO, OUT1) \
+    ((OUT1) == 0 ? PLL_PDA_MAX * PLL_PDB_MAX : (VCO) % (OUT1) ? 0 : (VCO) / (OUT1))
+
+/** Output frequency, computed as SystemCoreClockUpdate() does.
+ */
+#define PLL_OUT_HZ(HSE, REFDIV, FBDIV, FRAC, DIV) \
+    ((uint32_t)(((HSE) / (REFDIV) * (((uint64_t)(FBDIV) << PLL_FRAC_BITS) + (FRAC)) >> PLL_FRAC_BITS) / (DIV)))
+
+#define PLL_VALID(HSE, REFDIV, VCO, FBDIV, PD0B, PD1A)                                   \
+    ((HSE) / (REFDIV) >= PLL_PFD_MIN_HZ && (REFDIV) <= PLL_REFDIV_MAX &&                 \
+     (PD0B) > 0 && (VCO) >= PLL_VCO_MIN_HZ && (VCO) <= PLL_VCO_MAX_HZ &&                 \
+     (FBDIV) >= PLL_FBDIV_MIN && (FBDIV) <= PLL_FBDIV_MAX && (PD1A) > 0)
+
+/** Divider values of a solved PLL (not register fields).
+ */
+typedef struct {
+    uint32_t refdiv;
+    uint32_t fbdiv;
+    uint32_t frac;
+    uint32_t pd0a;
+    uint32_t pd0b;
+    uint32_t pd1a;
+    uint32_t pd1b;
+    uint32_t vco_hz;
+    uint32_t out0_hz;
+    uint32_t out1_hz;
+    int valid;
+} pll_config_t;
+
+/** Enumerators NAME_REFDIV ... NAME_OUT1_HZ of a PLL solved for OUT0/OUT1,
+ * the same steps as pll_solve() below. Enumerators keep every step a named
+ * constant, so the expressions stay short and work in C where a constexpr
+ * cannot: enum { PLL_PROFILE(NAME, HSE, OUT0, OUT1) };
+ */
+#define PLL_PROFILE(NAME, HSE, OUT0, OUT1)                                                              \
+    NAME##_REFDIV = PLL_REFDIV(HSE),                                                                    \
+    NAME##_PD0A = PLL_PD0A(HSE, NAME##_REFDIV, OUT0),                                                   \
+    NAME##_PD0B = PLL_PDB_FOR(OUT0, NAME##_PD0A),                                                       \
+    NAME##_VCO_HZ = NAME##_PD0B ? (uint32_t)PLL_VCO_FOR(OUT0, NAME##_PD0A) : 0,                         \
+    NAME##_FBDIV = PLL_FBDIV(HSE, NAME##_REFDIV, NAME##_VCO_HZ),                                        \
+    NAME##_FRAC = PLL_FRAC(HSE, NAME##_REFDIV, NAME##_VCO_HZ),                                          \
+    NAME##_DIV1 = PLL_DIV1(NAME##_VCO_HZ, OUT1),                                                        \
+    NAME##_PD1A = PLL_PDA_SPLIT(NAME##_DIV1),                                                           \
+    NAME##_PD1B = NAME##_PD1A ? NAME##_DIV1 / NAME##_PD1A : 0,                                          \
+    NAME##_VALID = PLL_VALID(HSE, NAME##_REFDIV, NAME##_VCO_HZ, NAME##_FBDIV, NAME##_PD0B, NAME##_PD1A), \
+    NAME##_OUT0_HZ = NAME##_VALID ?                                                                     \
+        PLL_OUT_HZ(HSE, NAME##_REFDIV, NAME##_FBDIV, NAME##_FRAC, NAME##_PD0A * NAME##_PD0B) : 0,       \
+    NAME##_OUT1_HZ = NAME##_VALID ? PLL_OUT_HZ(HSE, NAME##_REFDIV, NAME##_FBDIV, NAME##_FRAC, NAME##_DIV1) : 0
+
+/** pll_config_t initializer of a PLL_PROFILE().
+ */
+#define PLL_PROFILE_CONFIG(NAME)                                                                        \
+    { NAME##_REFDIV, NAME##_FBDIV, NAME##_FRAC, NAME##_PD0A, NAME##_PD0B, NAME##_PD1A, NAME##_PD1B,     \
+      NAME##_VCO_HZ, NAME##_OUT0_HZ, NAME##_OUT1_HZ, NAME##_VALID }
+
+/** The profile reaches OUT0/OUT1 within SYSCLK_PLL_TOLERANCE_HZ (OUT1 = 0 is not checked).
+ */
+#define PLL_PROFILE_EXACT(NAME, OUT0, OUT1)                                                             \
+    (PLL_ABS_DIFF((uint32_t)NAME##_OUT0_HZ, (uint32_t)(OUT0)) <= SYSCLK_PLL_TOLERANCE_HZ &&             \
+     ((OUT1) == 0 || PLL_ABS_DIFF((uint32_t)NAME##_OUT1_HZ, (uint32_t)(OUT1)) <= SYSCLK_PLL_TOLERANCE_HZ))
+
+#if HSECLK_VAL
+
+/** The system PLL.
+ */
+enum { PLL_PROFILE(PLL_SYS, HSECLK_VAL, SYSCLK_PLL_HZ, SYSCLK_PLL1_HZ) };
+
+#endif // HSECLK_VAL
+
+#if defined SYSCLK_PLL
+    #if HSECLK_VAL == 0
+        #error "SYSCLK_PLL runs from HSE, define HSECLK_VAL"
+    #endif
+    #define SYSTEM_CORE_CLOCK_HZ PLL_SYS_OUT0_HZ
+#elif defined SYSCLK_HSE
+    #define SYSTEM_CORE_CLOCK_HZ HSECLK_VAL
+#elif defined SYSCLK_LSI
+    #define SYSTEM_CORE_CLOCK_HZ LSICLK_VAL
+#else
+    #define SYSTEM_CORE_CLOCK_HZ HSICLK_VAL
+#endif
+
+#ifdef __cplusplus
+
+#define PLL_STATIC_ASSERT static_assert
+
+/** Solve a PLL for any target, e.g. pll_solve(HSECLK_VAL, 48000000, 0) for USB.
+ * Use in a constexpr context together with static_assert on .valid.
+ */
+constexpr pll_config_t pll_solve(uint32_t hse, uint32_t out0, uint32_t out1)
+{
+    const uint32_t refdiv = hse ? PLL_REFDIV(hse) : 1;
+    const uint32_t pd0a = hse ? PLL_PD0A(hse, refdiv, out0) : 0;
+    const uint32_t pd0b = hse ? PLL_PDB_FOR(out0, pd0a) : 0;
+    const uint32_t vco = pd0b ? (uint32_t)PLL_VCO_FOR(out0, pd0a) : 0;
+    const uint32_t fbdiv = hse ? (uint32_t)PLL_FBDIV(hse, refdiv, vco) : 0;
+    const uint32_t frac = hse ? (uint32_t)PLL_FRAC(hse, refdiv, vco) : 0;
+    const uint32_t div1 = PLL_DIV1(vco, out1);
+    const uint32_t pd1a = PLL_PDA_SPLIT(div1);
+    const int valid = hse && PLL_VALID(hse, refdiv, vco, fbdiv, pd0b, pd1a);
+
+    return pll_config_t{
+        refdiv, fbdiv, frac, pd0a, pd0b, pd1a, pd1a ? div1 / pd1a : 0, vco,
+        valid ? PLL_OUT_HZ(hse, refdiv, fbdiv, frac, pd0a * pd0b) : 0,
+        valid ? PLL_OUT_HZ(hse, refdiv, fbdiv, frac, div1) : 0,
+        valid
+    };
+}
+
+#else // __cplusplus
+
+#define PLL_STATIC_ASSERT _Static_assert
+
+#endif // __cplusplus
+
+#if defined SYSCLK_PLL
+PLL_STATIC_ASSERT(PLL_SYS_VALID, "SYSCLK_PLL_HZ / SYSCLK_PLL1_HZ cannot be reached from HSECLK_VAL");
+PLL_STATIC_ASSERT(PLL_PROFILE_EXACT(PLL_SYS, SYSCLK_PLL_HZ, SYSCLK_PLL1_HZ),
+                  "SYSCLK_PLL_HZ / SYSCLK_PLL1_HZ are only reached approximately, see SYSCLK_PLL_TOLERANCE_HZ");
+#endif
+
+#endif // CLK_CONFIG_H
@@ -3,17 +3,27 @@
 
 #include <stdint.h>
 
+#include "clk_config.h"
+
 #define RISCV_MTIMECMP_ADDR (0x2000000 + 0x4000)
 #define RISCV_MTIME_ADDR    (0x2000000 + 0xBFF8)
 
-#ifndef MTIME_FREQ_HZ
-	#if defined SYSCLK_HSI
-		MTIME_FREQ_HZ 1000000ULL
-	#elif defined SYSCLK_HSE
-		#define MTIME_FREQ_HZ HSECLK_VAL
-	#else
-		#define MTIME_FREQ_HZ 50000000ULL
-	#endif
+/** mtime counts SYSCLK, MTIME_BOOT_FREQ_HZ is the clock selected by ClkInit().
+ */
+#ifndef MTIME_BOOT_FREQ_HZ
+	#define MTIME_BOOT_FREQ_HZ ((uint64_t)SYSTEM_CORE_CLOCK_HZ)
+#endif
+
+/** With MTIMER_DYNAMIC_FREQ the clock may change at run time (perf.h), so the
+ * conversions below read the current mtime rate from mtimer_freq_hz.
+ * Deadlines already programmed keep their mtime value, i.e. they stretch or
+ * shrink with the clock ratio.
+ */
+#ifdef MTIMER_DYNAMIC_FREQ
+extern volatile uint32_t mtimer_freq_hz;
+#define MTIME_FREQ_HZ ((uint64_t)mtimer_freq_hz)
+#elif !defined MTIME_FREQ_HZ
+#define MTIME_FREQ_HZ MTIME_BOOT_FREQ_HZ
 #endif
 
 #define MTIMER_SECONDS_TO_CLOCKS(SEC)           \
@@ -25,6 +35,35 @@
 #define MTIMER_USEC_TO_CLOCKS(USEC)           \
     ((uint64_t)(((USEC)*(MTIME_FREQ_HZ))/1000000))
 
+/** Delays shorter than this are busy-waited instead of parking the hart in wfi.
+ * Entering and leaving wfi costs a few clocks, so very short delays are more
+ * accurate when polled.
+ */
+#ifndef MTIMER_SLEEP_WFI_MIN_CLOCKS
+#define MTIMER_SLEEP_WFI_MIN_CLOCKS MTIMER_USEC_TO_CLOCKS(1)
+#endif
+
+#ifdef MTIMER_SLEEP_STATS
+/** Wake-up latency statistics of sleep()/usleep() in system timer clocks.
+ * Latency is the time between the deadline and the moment the delay returns,
+ * jitter is max_latency - min_latency.
+ */
+typedef struct {
+    uint32_t count;        // Number of finished delays
+    uint32_t wakeups;      // Number of wfi wake-ups (incl. early ones by other interrupts)
+    uint32_t last_latency;
+    uint32_t min_latency;
+    uint32_t max_latency;
+    uint64_t sum_latency;
+} mtimer_sleep_stats_t;
+
+extern volatile mtimer_sleep_stats_t mtimer_sleep_stats;
+
+/** Reset the sleep statistics.
+ */
+void mtimer_sleep_stats_reset(void);
+#endif // MTIMER_SLEEP_STATS
+
 /** Set the raw time compare point in system timer clocks.
  * @param clock_offset Time relative to current mtime when 
  * @note The time range of the 64 bit timer is large enough not to consider a wrap around of mtime.
@@ -33,10 +72,27 @@
  */
 void mtimer_set_raw_time_cmp(uint64_t clock_offset);
 
+/** Set the absolute time compare point in system timer clocks.
+ */
+void mtimer_set_raw_time_cmp_abs(uint64_t new_mtimecmp);
+
+/** Read the absolute time compare point in system timer clocks.
+ */
+uint64_t mtimer_get_raw_time_cmp(void);
+
 /** Read the raw time of the system timer in system timer clocks
  */
 uint64_t mtimer_get_raw_time(void);
 
+/** Block until mtime reaches the absolute deadline.
+ * The hart is parked in wfi with the machine timer interrupt enabled in mie
+ * and global interrupts masked, so the timer wakes the hart without a trap.
+ * Other pending interrupts are serviced between wake-ups.
+ * @note If MTIE is already enabled (e.g. by swtimer), the owner's compare point
+ * is honoured and restored, so its interrupt is taken between wake-ups.
+ */
+void mtimer_sleep_until(uint64_t deadline);
+
 void sleep(uint32_t ms);
 void usleep(uint32_t us);
 
@@ -0,0 +1,125 @@
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mtimer.h"
+
+/** Software timers multiplexed onto the single machine timer comparator.
+ *
+ * Timers are kept in a hierarchical timing wheel: SWTIMER_LEVELS levels of
+ * SWTIMER_LEVEL_SLOTS slots each, plus an overflow list for timers beyond the
+ * wheel range. Start and stop are O(1), the next expiry is found with one
+ * count-trailing-zeros per level over the slot occupancy bitmaps.
+ *
+ * The wheel is tickless: mtimecmp is programmed only for the next expiry (or
+ * the next cascade of a higher level), callbacks are called from the machine
+ * timer interrupt with global interrupts disabled.
+ */
+
+/** Tick length as a power of two of system timer clocks.
+ * 2^10 clocks is 20.48 us at 50 MHz, the wheel then covers ~6 hours before
+ * timers spill into the overflow list.
+ */
+#ifndef SWTIMER_TICK_SHIFT
+#define SWTIMER_TICK_SHIFT 10
+#endif
+
+#define SWTIMER_LEVEL_BITS  5
+#define SWTIMER_LEVEL_SLOTS (1u << SWTIMER_LEVEL_BITS)
+#define SWTIMER_LEVELS      6
+#define SWTIMER_WHEEL_BITS  (SWTIMER_LEVEL_BITS * SWTIMER_LEVELS)
+
+#define SWTIMER_CLOCKS_TO_TICKS(CLOCKS)       \
+    ((uint64_t)(CLOCKS) >> SWTIMER_TICK_SHIFT)
+
+#define SWTIMER_MSEC_TO_TICKS(MSEC)           \
+    ((uint32_t)((MTIMER_MSEC_TO_CLOCKS(MSEC) + (1u << SWTIMER_TICK_SHIFT) - 1) >> SWTIMER_TICK_SHIFT))
+
+#define SWTIMER_USEC_TO_TICKS(USEC)           \
+    ((uint32_t)((MTIMER_USEC_TO_CLOCKS(USEC) + (1u << SWTIMER_TICK_SHIFT) - 1) >> SWTIMER_TICK_SHIFT))
+
+typedef struct swtimer swtimer_t;
+
+/** Timer callback, called from the machine timer interrupt.
+ * The callback may start or stop any timer, including its own.
+ */
+typedef void swtimer_func_t(swtimer_t *timer, void *arg);
+
+/** Software timer. The fields are private, use the functions below.
+ */
+struct swtimer {
+    swtimer_t *next;
+    swtimer_t **pprev;      // NULL if the timer is not active
+    uint64_t expires;       // Absolute expiry in ticks
+    uint32_t period;        // Reload period in ticks, 0 for a one-shot timer
+    swtimer_func_t *func;
+    void *arg;
+    uint16_t slot;          // level * SWTIMER_LEVEL_SLOTS + index
+};
+
+#ifdef SWTIMER_STATS
+/** Dispatch statistics, the cycle counts are taken from mcycle.
+ */
+typedef struct {
+    uint32_t active;         // Number of running timers
+    uint32_t dispatches;     // Number of swtimer_process() calls
+    uint32_t expired;        // Number of callbacks called
+    uint32_t cascaded;       // Number of timers moved to a lower level
+    uint32_t last_cycles;    // Cycles of the last dispatch (incl. callbacks)
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+} swtimer_stats_t;
+
+extern volatile swtimer_stats_t swtimer_stats;
+
+/** Reset the dispatch statistics (the active counter is kept).
+ */
+void swtimer_stats_reset(void);
+#endif // SWTIMER_STATS
+
+/** Initialize the wheel, install the machine timer handler and enable MTIE.
+ * @note InterruptEnable() clears MTIE, call it before swtimer_init().
+ */
+void swtimer_init(void);
+
+/** Prepare a timer for use.
+ */
+void swtimer_setup(swtimer_t *timer, swtimer_func_t *func, void *arg);
+
+/** (Re)start the timer.
+ * @param delay Ticks until the first expiry, the resolution is one tick.
+ * @param period Reload period in ticks, 0 for a one-shot timer.
+ */
+void swtimer_start(swtimer_t *timer, uint32_t delay, uint32_t period);
+
+/** (Re)start the timer at the absolute tick expires.
+ */
+void swtimer_start_at(swtimer_t *timer, uint64_t expires, uint32_t period);
+
+/** Stop the timer, does nothing if it is not active.
+ */
+void swtimer_stop(swtimer_t *timer);
+
+static inline bool swtimer_is_active(const swtimer_t *timer) {
+    return timer->pprev != 0;
+}
+
+/** Current time in ticks.
+ */
+static inline uint64_t swtimer_now(void) {
+    return SWTIMER_CLOCKS_TO_TICKS(mtimer_get_raw_time());
+}
+
+/** Run all expired timers and program mtimecmp for the next event.
+ * Called by the machine timer interrupt, may also be polled with interrupts
+ * disabled.
+ */
+void swtimer_process(void);
+
+/** Machine timer interrupt handler installed by swtimer_init().
+ */
+void swtimer_irq_handler(void);
+
+#endif // SWTIMER_H
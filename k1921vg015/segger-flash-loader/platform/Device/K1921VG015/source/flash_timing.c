@@ -0,0 +1,50 @@
+#include "flash_timing.h"
+#include "system_k1921vg015.h"
+#include "K1921VG015.h"
+
+uint32_t flash_latency_for(uint32_t hz)
+{
+    // kHz * ns stays within 32 bits up to 4 GHz * 1000 ns
+    uint32_t clocks = (hz / 1000 * FLASH_ACCESS_NS + 999999) / 1000000;
+
+    if (clocks == 0) return 0;
+    return clocks - 1 > FLASH_LAT_MAX ? FLASH_LAT_MAX : clocks - 1;
+}
+
+uint32_t flash_latency_get(void)
+{
+    return FLASH->CTRL_bit.LAT;
+}
+
+void flash_timing_prepare(uint32_t hz)
+{
+    uint32_t lat = flash_latency_for(hz);
+
+    if (lat > FLASH->CTRL_bit.LAT) FLASH->CTRL_bit.LAT = lat;
+}
+
+void flash_timing_update(uint32_t hz)
+{
+    FLASH->CTRL_bit.LAT = flash_latency_for(hz);
+    FLASH->CTRL_bit.CEN = 1;
+}
+
+int flash_latency_set(uint32_t lat)
+{
+    if (lat > FLASH_LAT_MAX || lat < flash_latency_for(SystemCoreClock)) return -1;
+
+    FLASH->CTRL_bit.LAT = lat;
+    return 0;
+}
+
+void flash_cache_enable(int enable)
+{
+    FLASH->CTRL_bit.CEN = enable ? 1 : 0;
+}
+
+void flash_cache_flush(void)
+{
+    // CFLUSH is a command bit, release it so the next flush is an edge again
+    FLASH->CTRL_bit.CFLUSH = 1;
+    FLASH->CTRL_bit.CFLUSH = 0;
+}
@@ -0,0 +1,93 @@
+#include <errno.h>
+#include <stddef.h>
+
+#include "mem_stats.h"
+#include "riscv-csr.h"
+
+extern uint32_t _heap_start[], _heap_end[];
+extern uint32_t __STACK_START__[], __STACK_END__[];
+
+volatile mem_stats_t mem_stats;
+
+static char *mem_heap_break;          // Current _sbrk() break
+static uint32_t *mem_stack_mark;      // Lowest stack word found in use
+static uint32_t *mem_scan_cursor;     // Next word of the running scan pass, NULL between passes
+
+void mem_stats_paint(void)
+{
+    uint32_t *sp;
+    uint32_t *p = _heap_start;
+
+    // Only the RAM below the caller's frame is free, this function itself is a leaf
+    __asm__ volatile ("mv %0, sp" : "=r"(sp));
+
+    while (p < sp) *p++ = MEM_STATS_PAINT;
+
+    mem_heap_break = (char *)_heap_start;
+    mem_stack_mark = sp < __STACK_END__ ? sp : __STACK_END__;
+    mem_scan_cursor = NULL;
+
+    mem_stats.stack_size = (uint32_t)((char *)__STACK_END__ - (char *)__STACK_START__);
+    mem_stats.stack_peak = (uint32_t)((char *)__STACK_END__ - (char *)mem_stack_mark);
+    mem_stats.stack_overflow = 0;
+    mem_stats.heap_size = (uint32_t)((char *)_heap_end - (char *)_heap_start);
+    mem_stats.heap_used = 0;
+    mem_stats.heap_peak = 0;
+    mem_stats.heap_failed = 0;
+    mem_stats.scans = 0;
+}
+
+int mem_stats_scan(void)
+{
+    uint32_t start = (uint32_t)csr_read_mcycle();
+    uint32_t *mark = mem_stack_mark;
+    uint32_t *p = mem_scan_cursor ? mem_scan_cursor : __STACK_START__;
+    uint32_t *end = mark - p > MEM_STATS_SCAN_WORDS ? p + MEM_STATS_SCAN_WORDS : mark;
+    int done = 1;
+
+    // Everything below the previous mark was painted then, find the first word that no longer is
+    while (p < end && *p == MEM_STATS_PAINT) p++;
+
+    if (p < end) {
+        mem_stack_mark = p;
+        mem_stats.stack_peak = (uint32_t)((char *)__STACK_END__ - (char *)p);
+        if (p == __STACK_START__) mem_stats.stack_overflow = 1;
+        mem_scan_cursor = NULL;
+    } else if (p < mark) {
+        // Painted so far, the pass goes on from here with the next call
+        mem_scan_cursor = p;
+        done = 0;
+    } else {
+        mem_scan_cursor = NULL;
+    }
+
+    mem_stats.scans++;
+    mem_stats.last_scan_cycles = (uint32_t)csr_read_mcycle() - start;
+    return done;
+}
+
+void *_sbrk(ptrdiff_t incr)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    char *base = mem_heap_break;
+
+    // Not painted yet (called before plf_init()): start at the heap base anyway
+    if (!base) base = (char *)_heap_start;
+
+    if (base + incr > (char *)_heap_end || base + incr < (char *)_heap_start) {
+        mem_stats.heap_failed++;
+        csr_write_mstatus(mstatus);
+        errno = ENOMEM;
+        return (void *)-1;
+    }
+
+    mem_heap_break = base + incr;
+
+    uint32_t used = (uint32_t)(mem_heap_break - (char *)_heap_start);
+
+    mem_stats.heap_used = used;
+    if (used > mem_stats.heap_peak) mem_stats.heap_peak = used;
+
+    csr_write_mstatus(mstatus);
+    return base;
+}
@@ -1,4 +1,15 @@
 #include "mtimer.h"
+#include "riscv-csr.h"
+#include "riscv-irq.h"
+#include "trace.h"
+
+#ifdef MTIMER_DYNAMIC_FREQ
+volatile uint32_t mtimer_freq_hz = MTIME_BOOT_FREQ_HZ;
+#endif
+
+#ifdef MTIMER_SLEEP_STATS
+volatile mtimer_sleep_stats_t mtimer_sleep_stats = { .min_latency = UINT32_MAX };
+#endif
 
 void mtimer_set_raw_time_cmp(uint64_t clock_offset) {
     // First of all set 
@@ -32,18 +43,106 @@ uint64_t mtimer_get_raw_time(void) {
     return (uint64_t) ( ( ((uint64_t)mtimeh_val)<<32) | mtimel_val);
 } 
 
+/** Set the absolute time compare point in system timer clocks.
+ */
+void mtimer_set_raw_time_cmp_abs(uint64_t new_mtimecmp) {
+    volatile uint32_t *mtimecmpl = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR);
+    volatile uint32_t *mtimecmph = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR+4);
+    // Same write order as in mtimer_set_raw_time_cmp()
+    *mtimecmpl = 0xFFFFFFFF;  // cppcheck-suppress redundantAssignment
+    *mtimecmph = (uint32_t)(new_mtimecmp >> 32); // cppcheck-suppress redundantAssignment
+    *mtimecmpl = (uint32_t)(new_mtimecmp & 0x0FFFFFFFFUL);
+}
+
+/** Read the absolute time compare point in system timer clocks.
+ */
+uint64_t mtimer_get_raw_time_cmp(void) {
+    volatile uint32_t *mtimecmpl = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR);
+    volatile uint32_t *mtimecmph = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR+4);
+    return (uint64_t) ( ( ((uint64_t)*mtimecmph)<<32) | *mtimecmpl);
+}
+
+#ifdef MTIMER_SLEEP_STATS
+void mtimer_sleep_stats_reset(void)
+{
+    mtimer_sleep_stats.count = 0;
+    mtimer_sleep_stats.wakeups = 0;
+    mtimer_sleep_stats.last_latency = 0;
+    mtimer_sleep_stats.min_latency = UINT32_MAX;
+    mtimer_sleep_stats.max_latency = 0;
+    mtimer_sleep_stats.sum_latency = 0;
+}
+
+static void mtimer_sleep_stats_update(uint64_t deadline)
+{
+    uint32_t latency = (uint32_t)(mtimer_get_raw_time() - deadline);
+
+    mtimer_sleep_stats.count++;
+    mtimer_sleep_stats.last_latency = latency;
+    mtimer_sleep_stats.sum_latency += latency;
+    if (latency < mtimer_sleep_stats.min_latency) mtimer_sleep_stats.min_latency = latency;
+    if (latency > mtimer_sleep_stats.max_latency) mtimer_sleep_stats.max_latency = latency;
+}
+#endif // MTIMER_SLEEP_STATS
+
+/** Block until mtime reaches the absolute deadline
+ */
+void mtimer_sleep_until(uint64_t deadline)
+{
+    uint64_t now = mtimer_get_raw_time();
+
+    TRACE_SLEEP_BEGIN(deadline > now ? deadline - now : 0);
+
+    while ((now = mtimer_get_raw_time()) < deadline) {
+        // Sub-microsecond remainder: wfi entry/exit would overshoot, poll instead
+        if (deadline - now < MTIMER_SLEEP_WFI_MIN_CLOCKS) {
+            while (mtimer_get_raw_time() < deadline);
+            break;
+        }
+
+        // Mask global interrupts: the timer only has to wake the hart, the
+        // trap is not needed for the delay itself
+        uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+        uint_xlen_t mie = csr_read_set_bits_mie(RISCV_IRQ_MASK_MTI);
+        // With MTIE already enabled mtimecmp belongs to someone else (swtimer):
+        // wake up for its compare point too and hand it back afterwards
+        uint64_t mtimecmp = (mie & RISCV_IRQ_MASK_MTI) ? mtimer_get_raw_time_cmp() : UINT64_MAX;
+
+        mtimer_set_raw_time_cmp_abs(mtimecmp < deadline ? mtimecmp : deadline);
+
+        // wfi also returns on any other enabled interrupt, it is serviced below
+        TRACE_WFI_ENTER();
+        __asm__ volatile ("wfi" ::: "memory");
+        TRACE_WFI_EXIT();
+
+        if (mie & RISCV_IRQ_MASK_MTI) {
+            mtimer_set_raw_time_cmp_abs(mtimecmp);
+        } else {
+            csr_clr_bits_mie(RISCV_IRQ_MASK_MTI);
+        }
+        csr_write_mstatus(mstatus);
+
+#ifdef MTIMER_SLEEP_STATS
+        mtimer_sleep_stats.wakeups++;
+#endif
+    }
+
+#ifdef MTIMER_SLEEP_STATS
+    mtimer_sleep_stats_update(deadline);
+#endif
+    TRACE_SLEEP_END();
+}
+
 /** Delay in ms
  */
 void sleep(uint32_t ms)
 {
-uint64_t end_time = mtimer_get_raw_time() + MTIMER_MSEC_TO_CLOCKS(ms);
-while (mtimer_get_raw_time() < end_time);
+mtimer_sleep_until(mtimer_get_raw_time() + MTIMER_MSEC_TO_CLOCKS(ms));
 }
 
 /** Delay in us
  */
 void usleep(uint32_t us)
 {
-uint64_t end_time = mtimer_get_raw_time() + MTIMER_USEC_TO_CLOCKS(us);
-while (mtimer_get_raw_time() < end_time);
+mtimer_sleep_until(mtimer_get_raw_time() + MTIMER_USEC_TO_CLOCKS(us));
 }
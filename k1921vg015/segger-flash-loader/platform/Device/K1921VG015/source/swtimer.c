@@ -0,0 +1,281 @@
+#include "swtimer.h"
+#include "riscv-csr.h"
+#include "riscv-irq.h"
+#include "trace.h"
+
+#define SWTIMER_SLOT_MASK     (SWTIMER_LEVEL_SLOTS - 1)
+#define SWTIMER_SLOT_OVERFLOW (SWTIMER_LEVELS * SWTIMER_LEVEL_SLOTS)
+#define SWTIMER_NEVER         UINT64_MAX
+
+/** Wheel state, kept in one object so it can be inspected from the debugger.
+ * A timer in level l shares all bits above level l with now, so its slot index
+ * is always ahead of the level's current index and no slot ever wraps.
+ */
+static struct {
+    uint64_t now;                                       // Last processed tick
+    uint64_t armed;                                     // Tick programmed into mtimecmp
+    uint32_t active;                                    // Number of running timers
+    uint32_t pending[SWTIMER_LEVELS];                   // Slot occupancy bitmaps
+    swtimer_t *slot[SWTIMER_LEVELS][SWTIMER_LEVEL_SLOTS];
+    swtimer_t *overflow;                                // Timers beyond the wheel range
+} swtimer_wheel;
+
+#ifdef SWTIMER_STATS
+volatile swtimer_stats_t swtimer_stats;
+
+void swtimer_stats_reset(void)
+{
+    swtimer_stats.dispatches = 0;
+    swtimer_stats.expired = 0;
+    swtimer_stats.cascaded = 0;
+    swtimer_stats.last_cycles = 0;
+    swtimer_stats.max_cycles = 0;
+    swtimer_stats.sum_cycles = 0;
+}
+#endif // SWTIMER_STATS
+
+static swtimer_t **swtimer_head(uint32_t slot) {
+    return slot == SWTIMER_SLOT_OVERFLOW ? &swtimer_wheel.overflow : &swtimer_wheel.slot[0][0] + slot;
+}
+
+/** Link the timer into the slot matching its expiry.
+ */
+static void swtimer_enqueue(swtimer_t *timer) {
+    uint64_t expires = timer->expires;
+    uint32_t slot;
+
+    // Overdue timers go to the current slot and are run by the next dispatch
+    if (expires < swtimer_wheel.now) expires = swtimer_wheel.now;
+
+    uint64_t diff = expires ^ swtimer_wheel.now;
+
+    if (diff >> SWTIMER_WHEEL_BITS) {
+        slot = SWTIMER_SLOT_OVERFLOW;
+    } else {
+        // The level is the highest slot index group in which expires differs from now
+        uint32_t level = diff ? (31 - __builtin_clz((uint32_t)diff)) / SWTIMER_LEVEL_BITS : 0;
+        uint32_t index = (uint32_t)(expires >> (level * SWTIMER_LEVEL_BITS)) & SWTIMER_SLOT_MASK;
+
+        swtimer_wheel.pending[level] |= 1u << index;
+        slot = level * SWTIMER_LEVEL_SLOTS + index;
+    }
+
+    swtimer_t **head = swtimer_head(slot);
+
+    timer->slot = slot;
+    timer->next = *head;
+    timer->pprev = head;
+    if (*head) (*head)->pprev = &timer->next;
+    *head = timer;
+}
+
+/** Unlink the timer and clear the slot bit when the slot runs empty.
+ */
+static void swtimer_dequeue(swtimer_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) timer->next->pprev = timer->pprev;
+
+    if (timer->slot != SWTIMER_SLOT_OVERFLOW && *swtimer_head(timer->slot) == 0) {
+        swtimer_wheel.pending[timer->slot / SWTIMER_LEVEL_SLOTS] &= ~(1u << (timer->slot & SWTIMER_SLOT_MASK));
+    }
+
+    timer->next = 0;
+    timer->pprev = 0;
+}
+
+/** Tick of the next expiry or cascade.
+ * Events in a lower level always precede the cascades of the levels above it.
+ */
+static uint64_t swtimer_next_event(void) {
+    uint64_t now = swtimer_wheel.now;
+
+    for (uint32_t level = 0; level < SWTIMER_LEVELS; level++) {
+        uint32_t shift = level * SWTIMER_LEVEL_BITS;
+        uint32_t index = (uint32_t)(now >> shift) & SWTIMER_SLOT_MASK;
+        // Level 0 expires in the current slot too, upper levels cascade at the start of a later slot
+        uint32_t pending = swtimer_wheel.pending[level] & (level ? (~0u << index) << 1 : ~0u << index);
+
+        if (pending) {
+            uint64_t base = now & ~((1ULL << (shift + SWTIMER_LEVEL_BITS)) - 1);
+            return base | ((uint64_t)__builtin_ctz(pending) << shift);
+        }
+    }
+
+    if (swtimer_wheel.overflow) {
+        return ((now >> SWTIMER_WHEEL_BITS) + 1) << SWTIMER_WHEEL_BITS;
+    }
+
+    return SWTIMER_NEVER;
+}
+
+/** Program mtimecmp for the next event. Called with interrupts disabled.
+ */
+static void swtimer_arm(void) {
+    uint64_t next = swtimer_next_event();
+
+    if (next == swtimer_wheel.armed) return;
+
+    swtimer_wheel.armed = next;
+    mtimer_set_raw_time_cmp_abs(next == SWTIMER_NEVER ? SWTIMER_NEVER : next << SWTIMER_TICK_SHIFT);
+}
+
+/** Move the timers of one slot down the wheel.
+ */
+static void swtimer_cascade(swtimer_t **head) {
+    swtimer_t *timer = *head;
+
+    *head = 0;
+
+    while (timer) {
+        swtimer_t *next = timer->next;
+
+        swtimer_enqueue(timer);
+#ifdef SWTIMER_STATS
+        swtimer_stats.cascaded++;
+#endif
+        timer = next;
+    }
+}
+
+void swtimer_process(void)
+{
+#ifdef SWTIMER_STATS
+    uint32_t start = (uint32_t)csr_read_mcycle();
+#endif
+    uint64_t target = swtimer_now();
+    uint64_t next;
+
+    while ((next = swtimer_next_event()) <= target) {
+        swtimer_wheel.now = next;
+
+        // Cascade top-down: a cascaded timer may land in the current slot of a lower level
+        if ((next & ((1ULL << SWTIMER_WHEEL_BITS) - 1)) == 0) {
+            swtimer_cascade(&swtimer_wheel.overflow);
+        }
+
+        for (uint32_t level = SWTIMER_LEVELS - 1; level > 0; level--) {
+            uint32_t shift = level * SWTIMER_LEVEL_BITS;
+
+            if (next & ((1ULL << shift) - 1)) continue;
+
+            uint32_t index = (uint32_t)(next >> shift) & SWTIMER_SLOT_MASK;
+
+            if (swtimer_wheel.pending[level] & (1u << index)) {
+                swtimer_wheel.pending[level] &= ~(1u << index);
+                swtimer_cascade(&swtimer_wheel.slot[level][index]);
+            }
+        }
+
+        swtimer_t **head = &swtimer_wheel.slot[0][next & SWTIMER_SLOT_MASK];
+        swtimer_t *timer;
+
+        // Periodic timers that are behind schedule are re-queued into this slot and caught up here
+        while ((timer = *head) != 0) {
+            swtimer_dequeue(timer);
+
+            if (timer->period) {
+                timer->expires += timer->period;
+                swtimer_enqueue(timer);
+            } else {
+                swtimer_wheel.active--;
+            }
+
+#ifdef SWTIMER_STATS
+            swtimer_stats.expired++;
+#endif
+            TRACE_TIMER_ENTER(timer->func);
+            timer->func(timer, timer->arg);
+            TRACE_TIMER_EXIT();
+        }
+    }
+
+    // No event up to target: skipping the empty ticks keeps all slot indices valid.
+    // A callback restarting an idle wheel may already have moved now past target.
+    if (swtimer_wheel.now < target) swtimer_wheel.now = target;
+    swtimer_arm();
+
+#ifdef SWTIMER_STATS
+    uint32_t cycles = (uint32_t)csr_read_mcycle() - start;
+
+    swtimer_stats.active = swtimer_wheel.active;
+    swtimer_stats.dispatches++;
+    swtimer_stats.last_cycles = cycles;
+    swtimer_stats.sum_cycles += cycles;
+    if (cycles > swtimer_stats.max_cycles) swtimer_stats.max_cycles = cycles;
+#endif
+}
+
+void swtimer_irq_handler(void)
+{
+    swtimer_process();
+}
+
+void swtimer_init(void)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    swtimer_wheel.now = swtimer_now();
+    swtimer_wheel.armed = SWTIMER_NEVER;
+    mtimer_set_raw_time_cmp_abs(SWTIMER_NEVER);
+
+    riscv_irq_set_handler(RISCV_IRQ_MTI, swtimer_irq_handler);
+    csr_set_bits_mie(RISCV_IRQ_MASK_MTI);
+
+    csr_write_mstatus(mstatus);
+}
+
+void swtimer_setup(swtimer_t *timer, swtimer_func_t *func, void *arg)
+{
+    timer->next = 0;
+    timer->pprev = 0;
+    timer->expires = 0;
+    timer->period = 0;
+    timer->func = func;
+    timer->arg = arg;
+    timer->slot = 0;
+}
+
+void swtimer_start_at(swtimer_t *timer, uint64_t expires, uint32_t period)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    if (timer->pprev) {
+        swtimer_dequeue(timer);
+    } else {
+        // An idle wheel may lag far behind, catch up so the timer lands in a low level
+        if (swtimer_wheel.active++ == 0) swtimer_wheel.now = swtimer_now();
+    }
+
+    timer->expires = expires;
+    timer->period = period;
+    swtimer_enqueue(timer);
+    swtimer_arm();
+
+#ifdef SWTIMER_STATS
+    swtimer_stats.active = swtimer_wheel.active;
+#endif
+
+    csr_write_mstatus(mstatus);
+}
+
+void swtimer_start(swtimer_t *timer, uint32_t delay, uint32_t period)
+{
+    swtimer_start_at(timer, swtimer_now() + delay, period);
+}
+
+void swtimer_stop(swtimer_t *timer)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    if (timer->pprev) {
+        swtimer_dequeue(timer);
+        swtimer_wheel.active--;
+        // mtimecmp is left as is, an early interrupt finds nothing to do and re-arms
+    }
+
+#ifdef SWTIMER_STATS
+    swtimer_stats.active = swtimer_wheel.active;
+#endif
+
+    csr_write_mstatus(mstatus);
+}
@@ -6,28 +6,73 @@
 #include <unistd.h>
 
 #include "memasm.h"
+#include "mem_stats.h"
+#include "riscv-csr.h"
+#include "sys_init.h"
 
 extern char _tdata_start[], _tdata_end[], _tbss_start[], _tbss_end[];
 
-extern const uint8_t __data_source_start;
-extern uint8_t __data_target_start;
-extern uint8_t __data_target_end;
+extern const uint8_t __init_array_target_start;
+extern const uint8_t __init_array_target_end;
 
-extern const uint8_t __sdata_source_start;
-extern uint8_t __sdata_target_start;
-extern uint8_t __sdata_target_end;
+extern void plf_init_relocate(void) __attribute__((weak));
 
-extern const uint8_t __init_array_source_start;
-extern uint8_t __init_array_target_start;
-extern uint8_t __init_array_target_end;
+extern char __bss_start[], __bss_end[];
 
-extern const uint8_t __fini_array_source_start;
-extern uint8_t __fini_array_target_start;
-extern uint8_t __fini_array_target_end;
+/** Boot descriptors emitted by the linker script, addresses and sizes are word aligned.
+ */
+typedef struct {
+    const uint32_t *src;
+    uint32_t *dst;
+    uint32_t size;
+} plf_copy_desc_t;
 
-extern void plf_init_relocate(void) __attribute__((weak));
+typedef struct {
+    uint32_t *dst;
+    uint32_t size;
+} plf_zero_desc_t;
 
-extern char __bss_start[], __bss_end[];
+extern const plf_copy_desc_t __copy_table_start[], __copy_table_end[];
+extern const plf_zero_desc_t __zero_table_start[], __zero_table_end[];
+
+volatile boot_stats_t boot_stats;
+
+// The loops must not be turned back into memcpy()/memset() calls
+#define __init_loop __init __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+static void __init_loop plf_copy_words(uint32_t *dst, const uint32_t *src, uint32_t size)
+{
+    uint32_t *end = (uint32_t *)((char *)dst + size);
+
+    // Four loads issued back to back overlap the flash wait states
+    while (end - dst >= 4) {
+        uint32_t w0 = src[0], w1 = src[1], w2 = src[2], w3 = src[3];
+
+        dst[0] = w0;
+        dst[1] = w1;
+        dst[2] = w2;
+        dst[3] = w3;
+        dst += 4;
+        src += 4;
+    }
+
+    while (dst < end) *dst++ = *src++;
+}
+
+static void __init_loop plf_zero_words(uint32_t *dst, uint32_t size)
+{
+    uint32_t *end = (uint32_t *)((char *)dst + size);
+
+    while (end - dst >= 4) {
+        dst[0] = 0;
+        dst[1] = 0;
+        dst[2] = 0;
+        dst[3] = 0;
+        dst += 4;
+    }
+
+    while (dst < end) *dst++ = 0;
+}
 
 void __init plf_init_noreloc(void)
 {
@@ -36,28 +81,35 @@ void __init plf_init_noreloc(void)
 
 void __init plf_init_generic(void)
 {
+    uint32_t start = (uint32_t)csr_read_mcycle();
+
+    // init .fini_array, .sdata, .data, .ramfunc and .fastdata,
+    // the copy tails may spill into .bss, so it is cleared last
+    for (const plf_copy_desc_t *desc = __copy_table_start; desc < __copy_table_end; desc++)
+        plf_copy_words(desc->dst, desc->src, desc->size);
+
+    // make the copied .ramfunc visible to instruction fetch (fence.i, the -march has no Zifencei)
+    __asm__ volatile (".insn i 0x0F, 1, x0, x0, 0" ::: "memory");
+
     // init BSS
-    memset(__bss_start, 0, (size_t)(__bss_end - __bss_start));
+    for (const plf_zero_desc_t *desc = __zero_table_start; desc < __zero_table_end; desc++)
+        plf_zero_words(desc->dst, desc->size);
 
-    memcpy((void*)&__data_target_start,
-           (const void*)&__data_source_start,
-           (&__data_target_end - &__data_target_start));
+    // paint the free heap and stack for the high-water marks
+    mem_stats_paint();
 
-    memcpy((void*)&__sdata_target_start,
-              (const void*)&__sdata_source_start,
-              (&__sdata_target_end - &__sdata_target_start));
+    uint32_t ctors = (uint32_t)csr_read_mcycle();
 
-    memcpy((void*)&__init_array_target_start,
-              (const void*)&__init_array_source_start,
-              (&__init_array_target_end - &__init_array_target_start));
+    // init functions for cpp, .init_array is left in flash and called in place
+    typedef void (*plf_ctor_t)(void);
 
-    memcpy((void*)&__fini_array_target_start,
-              (const void*)&__fini_array_source_start,
-              (&__fini_array_target_end - &__fini_array_target_start));
+    for (const plf_ctor_t *ctor = (const plf_ctor_t *)&__init_array_target_start;
+         ctor < (const plf_ctor_t *)&__init_array_target_end; ctor++)
+        (*ctor)();
 
-    // init functions for cpp
-    for (uint32_t i = 0; i < ((uint32_t) (&__init_array_target_end - &__init_array_target_start)) >> 2; i++)
-    	((void (*)())((uint32_t*)&__init_array_target_start)[i])();
+    boot_stats.init_start = start;
+    boot_stats.init_cycles = ctors - start;
+    boot_stats.ctors_cycles = (uint32_t)csr_read_mcycle() - ctors;
 }
 
 void plf_init(void) __attribute__((weak, alias("plf_init_generic")));
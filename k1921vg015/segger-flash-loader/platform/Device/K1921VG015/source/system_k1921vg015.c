@@ -21,6 +21,7 @@
 //-- Includes ------------------------------------------------------------------
 #include "system_k1921vg015.h"
 #include "plic.h"
+#include "flash_timing.h"
 #include "K1921VG015.h"
 
 //-- Variables -----------------------------------------------------------------
@@ -47,7 +48,7 @@ void SystemCoreClockUpdate(void)
 	{	
 		if (RCU->PLLSYSCFG0_bit.DSMEN)	// Если дробный делитель включен
 		{
-			uint64_t fbdiv = RCU->PLLSYSCFG2_bit.FBDIV << 24;
+			uint64_t fbdiv = (uint64_t)RCU->PLLSYSCFG2_bit.FBDIV << 24;
 			uint32_t frac = RCU->PLLSYSCFG1_bit.FRAC;
 			SystemPll0Clock = (((HSECLK_VAL / refdiv) * (fbdiv + frac)) >> 24) / (pd0a * pd0b);
 			SystemPll1Clock = (((HSECLK_VAL / refdiv) * (fbdiv + frac)) >> 24) / (pd1a * pd1b);
@@ -83,7 +84,7 @@ void SystemCoreClockUpdate(void)
 
 			if (USB->PLLUSBCFG0_bit.DSMEN)		// Если дробный делитель включен
 			{
-				uint64_t fbdiv = USB->PLLUSBCFG2_bit.FBDIV << 24;
+				uint64_t fbdiv = (uint64_t)USB->PLLUSBCFG2_bit.FBDIV << 24;
 				uint32_t frac = USB->PLLUSBCFG1_bit.FRAC;
 
 				USBClock = (((HSECLK_VAL / refdiv) * (fbdiv + frac)) >> 24) / (pd0a * pd0b);
@@ -94,6 +95,9 @@ void SystemCoreClockUpdate(void)
 		} 
 		else USBClock = SystemCoreClock;
 	}
+
+	// Минимальная задержка флеш для новой частоты (при ошибке вычислений остаётся прежняя)
+	if (SystemCoreClock) flash_timing_update(SystemCoreClock);
 }
 
 void ClkInit()
@@ -152,84 +156,21 @@ void ClkInit()
     while ((RCU->CLKSTAT_bit.SRC != RCU->SYSCLKCFG_bit.SRC) && (timeout_counter < 100)){ //SYSCLK_SWITCH_TIMEOUT))
         timeout_counter++;
     }  						  
-#if (HSECLK_VAL == 10000000)
-// Fout0 = 50 000 000 Hz
-// Fout1 = 25 000 000 Hz
-	RCU->PLLSYSCFG0 =( 4 << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
-					 ( 7 << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
-					 ( 3 << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
-					 ( 4 << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
-					 ( 1 << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
-					 ( 0 << RCU_PLLSYSCFG0_FOUTEN_Pos)    |  //fouten
-					 ( 0 << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
-					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen
-					 ( 3 << RCU_PLLSYSCFG0_BYP_Pos)       |  //bypass
-					 ( 1 << RCU_PLLSYSCFG0_PLLEN_Pos);       //en
-	RCU->PLLSYSCFG1 = 0;          //FRAC = 0					 
-	RCU->PLLSYSCFG2 = 100;         //FBDIV
-#elif (HSECLK_VAL == 12000000)
-// Fout0 = 50 000 000 Hz
-// Fout1 = 25 000 000 Hz
-	RCU->PLLSYSCFG0 =( 5 << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
-					 ( 7 << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
-					 ( 3 << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
-					 ( 5 << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
-					 ( 1 << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
-					 ( 0 << RCU_PLLSYSCFG0_FOUTEN_Pos)    |  //fouten
-					 ( 0 << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
-					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen
-					 ( 3 << RCU_PLLSYSCFG0_BYP_Pos)       |  //bypass
-					 ( 1 << RCU_PLLSYSCFG0_PLLEN_Pos);       //en
-	RCU->PLLSYSCFG1 = 0;          //FRAC = 0					 
-	RCU->PLLSYSCFG2 = 100;         //FBDIV
-#elif (HSECLK_VAL == 16000000)
-// Fout0 = 50 000 000 Hz
-// Fout1 = 25 000 000 Hz
-	RCU->PLLSYSCFG0 =( 15 << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
-					 ( 3 << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
-					 ( 3 << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
-					 ( 7 << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
-					 ( 1 << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
-					 ( 0 << RCU_PLLSYSCFG0_FOUTEN_Pos)    |  //fouten
-					 ( 0 << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
-					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen
-					 ( 3 << RCU_PLLSYSCFG0_BYP_Pos)       |  //bypass
-					 ( 1 << RCU_PLLSYSCFG0_PLLEN_Pos);       //en
-	RCU->PLLSYSCFG1 = 0;          //FRAC = 0					 
-	RCU->PLLSYSCFG2 = 100;         //FBDIV
-#elif (HSECLK_VAL == 20000000)
-// Fout0 = 50 000 000 Hz
-// Fout1 = 25 000 000 Hz
-	RCU->PLLSYSCFG0 =( 4 << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
-					 ( 7 << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
-					 ( 3 << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
-					 ( 4 << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
-					 ( 2 << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
-					 ( 0 << RCU_PLLSYSCFG0_FOUTEN_Pos)    |  //fouten
-					 ( 0 << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
-					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen
-					 ( 3 << RCU_PLLSYSCFG0_BYP_Pos)       |  //bypass
-					 ( 1 << RCU_PLLSYSCFG0_PLLEN_Pos);       //en
-	RCU->PLLSYSCFG1 = 0;          //FRAC = 0					 
-	RCU->PLLSYSCFG2 = 100;         //FBDIV
-#elif (HSECLK_VAL == 24000000)
-// Fout0 = 50 000 000 Hz
-// Fout1 = 25 000 000 Hz
-	RCU->PLLSYSCFG0 =( 5 << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
-					 ( 7 << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
-					 ( 3 << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
-					 ( 5 << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
-					 ( 2 << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
+// Делители PLL рассчитываются при компиляции из HSECLK_VAL, SYSCLK_PLL_HZ и SYSCLK_PLL1_HZ (clk_config.h)
+// Fout0 = SYSCLK_PLL_HZ (по умолчанию 50 000 000 Hz)
+// Fout1 = SYSCLK_PLL1_HZ (по умолчанию 25 000 000 Hz)
+	RCU->PLLSYSCFG0 =( (PLL_SYS_PD1B - 1) << RCU_PLLSYSCFG0_PD1B_Pos) |  //PD1B
+					 ( (PLL_SYS_PD1A - 1) << RCU_PLLSYSCFG0_PD1A_Pos) |  //PD1A
+					 ( (PLL_SYS_PD0B - 1) << RCU_PLLSYSCFG0_PD0B_Pos) |  //PD0B
+					 ( (PLL_SYS_PD0A - 1) << RCU_PLLSYSCFG0_PD0A_Pos) |  //PD0A
+					 ( PLL_SYS_REFDIV << RCU_PLLSYSCFG0_REFDIV_Pos) 	  |  //refdiv
 					 ( 0 << RCU_PLLSYSCFG0_FOUTEN_Pos)    |  //fouten
-					 ( 0 << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
-					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen
+					 ( (PLL_SYS_FRAC != 0) << RCU_PLLSYSCFG0_DSMEN_Pos)     |  //dsmen
+					 ( 0 << RCU_PLLSYSCFG0_DACEN_Pos)     |  //dacen, с DSMEN не проверено на плате
 					 ( 3 << RCU_PLLSYSCFG0_BYP_Pos)       |  //bypass
 					 ( 1 << RCU_PLLSYSCFG0_PLLEN_Pos);       //en
-	RCU->PLLSYSCFG1 = 0;          //FRAC = 0					 
-	RCU->PLLSYSCFG2 = 100;         //FBDIV
-#else
-#error "Please define HSECLK_VAL with correct values!"
-#endif
+	RCU->PLLSYSCFG1 = PLL_SYS_FRAC;          //FRAC
+	RCU->PLLSYSCFG2 = PLL_SYS_FBDIV;         //FBDIV
 	RCU->PLLSYSCFG0_bit.FOUTEN = 1; 	// Fout0 Enable
 	timeout_counter = 1000;
 	while(timeout_counter) timeout_counter--;
@@ -238,9 +179,8 @@ void ClkInit()
 	RCU->PLLSYSCFG0_bit.BYP = 2; 		// Bypass for Fout1
 	//select PLL as source system clock
 	sysclk_source = RCU_SYSCLKCFG_SRC_SYSPLL0CLK;
-    // FLASH control settings
-    FLASH->CTRL_bit.LAT = 3;
-    FLASH->CTRL_bit.CEN = 1;
+    // FLASH control settings: wait states for the PLL clock before switching to it
+    flash_timing_prepare(PLL_SYS_OUT0_HZ);
 #elif defined SYSCLK_HSI
     sysclk_source = RCU_SYSCLKCFG_SRC_HSICLK;
 #elif defined SYSCLK_HSE
@@ -261,6 +201,9 @@ void ClkInit()
         while (1) {
         };*/
 
+    // LAT for the selected clock, lowered if it went down
+    SystemCoreClockUpdate();
+
 }
 
 void InterruptEnable()
@@ -0,0 +1,71 @@
+#include "trace.h"
+#include "mtimer.h"
+#include "riscv-csr.h"
+
+volatile trace_stats_t trace_stats;
+
+static trace_output_t *trace_output;
+static uint64_t trace_last;          // mtime of the last stored event
+static uint32_t trace_lost;          // Events lost since the last stored event
+
+static uint8_t *trace_put_varint(uint8_t *p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+/** Encode and store one event. Called with interrupts disabled.
+ */
+static unsigned trace_store(uint32_t head, uint32_t payload, uint64_t now) {
+    uint8_t event[1 + 10 + 5];
+    uint8_t *p = event;
+
+    *p++ = (uint8_t)head;
+    p = trace_put_varint(p, now - trace_last);
+    if (head & TRACE_PAYLOAD) p = trace_put_varint(p, payload);
+
+    if (!trace_output(event, (unsigned)(p - event))) return 0;
+
+    trace_last = now;
+    trace_stats.events++;
+    return 1;
+}
+
+void trace_emit(uint32_t head, uint32_t payload)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    if (trace_output) {
+        uint64_t now = mtimer_get_raw_time();
+
+        // Nothing is stored after a loss until the loss itself is reported
+        if (trace_lost && trace_store(TRACE_EV_OVERFLOW | TRACE_PAYLOAD, trace_lost, now)) trace_lost = 0;
+
+        if (trace_lost || !trace_store(head, payload, now)) {
+            trace_lost++;
+            trace_stats.lost++;
+        }
+    }
+
+    csr_write_mstatus(mstatus);
+}
+
+void trace_start(trace_output_t *output)
+{
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    trace_output = output;
+    trace_last = mtimer_get_raw_time();
+    trace_lost = 0;
+    trace_emit(TRACE_EV_START | TRACE_PAYLOAD, (uint32_t)MTIME_FREQ_HZ);
+
+    csr_write_mstatus(mstatus);
+}
+
+void trace_stop(void)
+{
+    trace_output = 0;
+}
@@ -6,6 +6,7 @@
 #include "K1921VG015.h"
 #include "system_k1921vg015.h"
 #include "plib015_flash.h"
+#include "flash_timing.h"
 #include "mtimer.h"
 #include "FlashOS.h"
 
@@ -18,6 +19,378 @@
     __NOP();     \
     __NOP()
 
+// Полином CRC-32 (отражённый), который J-Link передаёт в SEGGER_OPEN_CalcCRC().
+#define CRC32_POLY_REFLECTED 0xEDB88320UL
+
+// Значение стертой ячейки Flash.
+#define FLASH_ERASED_VALUE 0xFF
+
+// Формат заголовка записи RLE-потока (см. ProgramCompressed()).
+#define RLE_RUN_Msk        0x80
+#define RLE_LENGTH_Msk     0x7F
+#define RLE_LENGTH_EXT     0x7F
+
+// Область Flash, с которой работает загрузчик. Один и тот же исходник
+// собирается дважды: для основной области и (с LOADER_NVR) для NVR.
+// NVR не отображается на шину процессора, поэтому для J-Link она описана
+// окном за пределами адресного окна Flash (0x80000000..0x801FFFFF), где нет
+// ни памяти, ни регистров: по адресу 0 находятся регистры Debug.
+#ifdef LOADER_NVR
+#define LOADER_REGION          FLASH_Region_NVR
+#define LOADER_BASE            0x80200000UL
+#define LOADER_SIZE            MEM_FLASH_NVR_SIZE
+#define LOADER_PAGE_TOTAL      MEM_FLASH_NVR_PAGE_TOTAL
+#define LOADER_DEVICE_NAME     "K1921VG015 NVR"
+#else
+#define LOADER_REGION          FLASH_Region_Main
+#define LOADER_BASE            MEM_FLASH_BASE
+#define LOADER_SIZE            MEM_FLASH_SIZE
+#define LOADER_PAGE_TOTAL      MEM_FLASH_PAGE_TOTAL
+#define LOADER_DEVICE_NAME     "K1921VG015 Internal"
+#endif
+
+// Адрес для контроллера Flash: смещение от начала области.
+#define LOADER_CTRL_ADDR( Addr ) ( ( Addr ) - LOADER_BASE )
+
+// Порог (в страницах), начиная с которого EraseSector() пробует стереть
+// всю область одной командой вместо постраничного стирания.
+#ifndef LOADER_FULL_ERASE_THRESHOLD
+#define LOADER_FULL_ERASE_THRESHOLD ( LOADER_PAGE_TOTAL * 3 / 4 )
+#endif
+
+// Частота mtime в тактах на микросекунду (для статистики стирания).
+#define MTIME_CLOCKS_PER_USEC ( ( uint32_t ) ( MTIME_FREQ_HZ / 1000000 ) )
+
+/**
+ * @brief  Блок данных, читаемый контроллером Flash за одну команду (128 бит).
+ */
+typedef union
+{
+    uint32_t Word[MEM_FLASH_BUS_WIDTH_WORDS / sizeof( uint32_t )];
+    uint8_t Byte[MEM_FLASH_BUS_WIDTH_WORDS];
+
+} FlashBlock;
+
+/**
+ * @brief  Статистика работы загрузчика.
+ *
+ * @note   J-Link не очищает BSS, поэтому счётчики сбрасываются в Init().
+ *         Адрес переменной g_LoaderStats берётся из .map файла,
+ *         значения читаются отладчиком (например, mem32 в J-Link Commander).
+ */
+typedef struct
+{
+    uint32_t ProgrammedBlocks; // Записано 16-байтных блоков
+    uint32_t SkippedBlocks;    // Пропущено блоков (чистые или совпадающие)
+    uint32_t ErasedPages;      // Стёрто страниц по 4 КБ
+    uint32_t FullErases;       // Стираний всей области одной командой
+    uint32_t EraseTimeUs;      // Суммарное время стирания (мкс, по mtime)
+
+} LoaderStats;
+
+volatile LoaderStats g_LoaderStats;
+
+/**
+ * @brief  Максимальный размер области стирания за один вызов EraseSector().
+ *
+ * @note   По умолчанию J-Link передаёт не более 128 КБ (32 страницы).
+ *         Разрешаем всю Flash, чтобы полное обновление образа стиралось
+ *         одним вызовом и могло перейти на стирание всей области.
+ */
+const uint32_t SEGGER_FL_MaxBlocksizeErase __attribute__( ( used ) ) = LOADER_SIZE;
+
+// -----------------------------------------------------------------------------
+// Вспомогательные функции
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief  Чтение 16-байтного блока через контроллер Flash.
+ *
+ * @note   Чтение идёт командой контроллера, а не через шину кэша,
+ *         поэтому результат всегда соответствует содержимому массива,
+ *         даже сразу после программирования.
+ *
+ * @param  Addr: Адрес блока (выровнен на 16 байт).
+ * @param  pBlock: Буфер для прочитанных данных.
+ */
+SECTION_PRGCODE static void _ReadBlock( uint32_t Addr, FlashBlock* pBlock )
+{
+    FLASH_SetAddr( LOADER_CTRL_ADDR( Addr ) );
+
+    FLASH_SetCmd( FLASH_Cmd_Read, LOADER_REGION );
+
+    // Даем время аппаратуре взвести флаг BUSY.
+    __NOP5();
+
+    // Ждём завершения операции.
+    while ( FLASH_BusyStatus() ) {}
+
+    for ( uint32_t i = 0; i < MEM_FLASH_BUS_WIDTH_WORDS / sizeof( uint32_t ); i++ )
+    {
+        pBlock->Word[i] = FLASH_GetData( i );
+    }
+}
+
+
+/**
+ * @brief  Загрузка 16-байтного блока из буфера J-Link.
+ *
+ * @note   pSrcBuff может быть не выровнен на 4 байта. Для выровненного
+ *         буфера слова читаются напрямую, иначе собираются побайтно
+ *         (Little Endian).
+ *
+ * @param  pSrc: Исходные данные.
+ * @param  pBlock: Блок для записи во Flash.
+ */
+SECTION_PRGCODE static inline void _FetchBlock( const uint8_t* pSrc, FlashBlock* pBlock )
+{
+    if ( ( ( uint32_t ) pSrc & 3 ) == 0 )
+    {
+        const uint32_t* pWords = ( const uint32_t* ) pSrc;
+
+        pBlock->Word[0] = pWords[0];
+        pBlock->Word[1] = pWords[1];
+        pBlock->Word[2] = pWords[2];
+        pBlock->Word[3] = pWords[3];
+    }
+    else
+    {
+        for ( uint32_t i = 0; i < MEM_FLASH_BUS_WIDTH_WORDS / sizeof( uint32_t ); i++ )
+        {
+            pBlock->Word[i] = ( ( uint32_t ) pSrc[0] << 0 ) |
+                              ( ( uint32_t ) pSrc[1] << 8 ) |
+                              ( ( uint32_t ) pSrc[2] << 16 ) |
+                              ( ( uint32_t ) pSrc[3] << 24 );
+            pSrc += 4;
+        }
+    }
+}
+
+
+/**
+ * @brief  Проверка, что блок состоит из одних стертых значений.
+ *
+ * @param  pBlock: Данные для записи.
+ * @return 1 - Блок чистый, 0 - Блок содержит данные.
+ */
+SECTION_PRGCODE static inline int _IsBlockErased( const FlashBlock* pBlock )
+{
+    const uint32_t ErasedWord = FLASH_ERASED_VALUE * 0x01010101UL;
+
+    return ( pBlock->Word[0] & pBlock->Word[1] & pBlock->Word[2] & pBlock->Word[3] ) == ErasedWord;
+}
+
+
+#ifndef LOADER_DATA_OVERLAP
+/**
+ * @brief  Проверка, нужно ли записывать блок.
+ *
+ * @note   Блок из одних стертых значений после стирания записывать не нужно.
+ *         Блок, совпадающий с текущим содержимым Flash, тоже пропускается.
+ *
+ * @param  Addr: Адрес блока.
+ * @param  pBlock: Данные для записи.
+ * @return 1 - Запись не требуется, 0 - Блок нужно записать.
+ */
+SECTION_PRGCODE static int _IsBlockUnchanged( uint32_t Addr, const FlashBlock* pBlock )
+{
+    FlashBlock Current;
+
+    if ( _IsBlockErased( pBlock ) ) return 1;
+
+    _ReadBlock( Addr, &Current );
+
+    return ( ( Current.Word[0] ^ pBlock->Word[0] ) | ( Current.Word[1] ^ pBlock->Word[1] ) |
+             ( Current.Word[2] ^ pBlock->Word[2] ) | ( Current.Word[3] ^ pBlock->Word[3] ) ) == 0;
+}
+#endif
+
+
+/**
+ * @brief  Запись 16-байтного блока во Flash.
+ *
+ * @note   Функция не ждёт окончания своей записи, чтобы вызывающий код мог
+ *         в это время подготовить следующий блок. Регистры DATA трогаем
+ *         только после снятия BUSY: руководство не гарантирует, что данные
+ *         защёлкиваются в момент подачи команды.
+ *
+ *         С LOADER_DATA_OVERLAP регистры DATA загружаются, пока контроллер
+ *         ещё пишет предыдущий блок, после снятия BUSY остаются только ADDR
+ *         и CMD. Чтение для сравнения во время записи невозможно, поэтому
+ *         в этом режиме пропускаются только чистые блоки. Режим допустим,
+ *         только если контроллер защёлкивает DATA по команде (см. README).
+ *
+ * @param  Addr: Адрес блока (выровнен на 16 байт).
+ * @param  pBlock: Данные для записи.
+ */
+SECTION_PRGCODE static void _ProgramBlock( uint32_t Addr, const FlashBlock* pBlock )
+{
+#ifdef LOADER_DATA_OVERLAP
+    if ( _IsBlockErased( pBlock ) )
+    {
+        g_LoaderStats.SkippedBlocks++;
+
+        return;
+    }
+
+    // Заполняем 4 регистра данных (DATA[0]..DATA[3]) во время записи предыдущего блока.
+    FLASH_SetData( 0, pBlock->Word[0] );
+    FLASH_SetData( 1, pBlock->Word[1] );
+    FLASH_SetData( 2, pBlock->Word[2] );
+    FLASH_SetData( 3, pBlock->Word[3] );
+
+    // Ждём завершения предыдущей записи.
+    while ( FLASH_BusyStatus() ) {}
+
+    // Устанавливаем адрес.
+    FLASH_SetAddr( LOADER_CTRL_ADDR( Addr ) );
+#else
+    // Ждём завершения предыдущей записи.
+    while ( FLASH_BusyStatus() ) {}
+
+    if ( _IsBlockUnchanged( Addr, pBlock ) )
+    {
+        g_LoaderStats.SkippedBlocks++;
+
+        return;
+    }
+
+    // Устанавливаем адрес.
+    FLASH_SetAddr( LOADER_CTRL_ADDR( Addr ) );
+
+    // Заполняем 4 регистра данных (DATA[0]..DATA[3]).
+    FLASH_SetData( 0, pBlock->Word[0] );
+    FLASH_SetData( 1, pBlock->Word[1] );
+    FLASH_SetData( 2, pBlock->Word[2] );
+    FLASH_SetData( 3, pBlock->Word[3] );
+#endif
+
+    // Отправляем команду записи.
+    FLASH_SetCmd( FLASH_Cmd_Write, LOADER_REGION );
+
+    // Даем время аппаратуре взвести флаг BUSY.
+    __NOP5();
+
+    g_LoaderStats.ProgrammedBlocks++;
+}
+
+
+/**
+ * @brief  Стирание одной страницы области загрузчика.
+ *
+ * @param  Addr: Адрес страницы (выровнен на 4 КБ).
+ */
+SECTION_PRGCODE static void _ErasePage( uint32_t Addr )
+{
+    // Записываем адрес сектора.
+    FLASH_SetAddr( LOADER_CTRL_ADDR( Addr ) );
+
+    // Отправляем команду стирания сектора.
+    FLASH_SetCmd( FLASH_CMD_ERSEC_Msk, LOADER_REGION );
+
+    // Даем время аппаратуре взвести флаг BUSY.
+    __NOP5();
+
+    // Ждём завершения операции.
+    while ( FLASH_BusyStatus() ) {}
+}
+
+
+/**
+ * @brief  Проверка, что диапазон области загрузчика полностью стерт.
+ *
+ * @param  Addr: Начальный адрес (выровнен на 16 байт).
+ * @param  NumBytes: Размер области (кратен 16 байтам).
+ * @return 1 - Область чистая, 0 - Есть записанные данные.
+ */
+SECTION_PRGCODE static int _IsRangeErased( uint32_t Addr, uint32_t NumBytes )
+{
+    FlashBlock Block;
+
+    for ( uint32_t End = Addr + NumBytes; Addr < End; Addr += MEM_FLASH_BUS_WIDTH_WORDS )
+    {
+        _ReadBlock( Addr, &Block );
+
+        if ( ( Block.Word[0] & Block.Word[1] & Block.Word[2] & Block.Word[3] ) != 0xFFFFFFFFUL )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/**
+ * @brief  Программный расчёт отражённого CRC (побитно, без таблицы).
+ *
+ * @param  CRC: Текущее значение CRC.
+ * @param  pData: Данные.
+ * @param  NumBytes: Количество байт.
+ * @param  Polynom: Отражённый полином.
+ * @return Новое значение CRC.
+ */
+SECTION_PRGCODE static uint32_t _CalcCRCSoft( uint32_t CRC, const uint8_t* pData, uint32_t NumBytes, uint32_t Polynom )
+{
+    while ( NumBytes-- )
+    {
+        CRC ^= *pData++;
+
+        for ( int i = 0; i < 8; i++ )
+        {
+            CRC = ( CRC & 1 ) ? ( CRC >> 1 ) ^ Polynom : ( CRC >> 1 );
+        }
+    }
+
+    return CRC;
+}
+
+
+/**
+ * @brief  Зеркальное отражение битов 32-битного слова.
+ */
+SECTION_PRGCODE static uint32_t _ReverseBits( uint32_t Value )
+{
+    uint32_t Result = 0;
+
+    for ( int i = 0; i < 32; i++ )
+    {
+        Result = ( Result << 1 ) | ( Value & 1 );
+        Value >>= 1;
+    }
+
+    return Result;
+}
+
+
+/**
+ * @brief  Запуск блока CRC0 с начальным значением CRC-32.
+ *
+ * @note   Блок считает CRC-32 в прямом порядке битов. Отражённый вариант,
+ *         который использует J-Link, получается обращением входных слов
+ *         (REV_IN_Word) и результата (REV_OUT), а начальное значение
+ *         загружается в регистр в отражённом виде.
+ *
+ * @param  CRC: Текущее (отражённое) значение CRC.
+ */
+SECTION_PRGCODE static void _CRC0Start( uint32_t CRC )
+{
+    CRC_SetInit( CRC0, _ReverseBits( CRC ) );
+
+    CRC0->CR = ( CRC_CR_MODE_StandartCRC << CRC_CR_MODE_Pos ) |
+               ( CRC_CR_XOROUT_Disable << CRC_CR_XOROUT_Pos ) |
+               ( CRC_CR_POLYSIZE_POL32 << CRC_CR_POLYSIZE_Pos ) |
+               ( CRC_CR_REV_IN_REV_WORD << CRC_CR_REV_IN_Pos ) |
+               ( CRC_CR_REV_OUT_Enable << CRC_CR_REV_OUT_Pos );
+
+    CRC_SetPol( CRC0, 0x04C11DB7UL );
+
+    // Загружаем начальное значение в регистр данных.
+    CRC_ResetCmd( CRC0, ENABLE );
+    CRC_ResetCmd( CRC0, DISABLE );
+}
+
+
 // -----------------------------------------------------------------------------
 // Обязательные функции SEGGER Flash Loader API
 // -----------------------------------------------------------------------------
@@ -43,6 +416,16 @@ SECTION_PRGCODE int Init( uint32_t Addr, uint32_t Freq, uint32_t Func )
     // Обновление системной частоты.
     SystemCoreClockUpdate();
 
+    g_LoaderStats.ProgrammedBlocks = 0;
+    g_LoaderStats.SkippedBlocks = 0;
+    g_LoaderStats.ErasedPages = 0;
+    g_LoaderStats.FullErases = 0;
+    g_LoaderStats.EraseTimeUs = 0;
+
+    // Тактирование блока CRC0 для SEGGER_OPEN_CalcCRC().
+    RCU->CGCFGAHB_bit.CRC0EN = 1;
+    RCU->RSTDISAHB_bit.CRC0EN = 1;
+
     return OK;
 }
 
@@ -57,35 +440,59 @@ SECTION_PRGCODE int UnInit( uint32_t Func )
 {
     ( void ) Func;
 
+    // Запись и стирание идут мимо кэша: сбрасываем его, чтобы ядро и чтение
+    // через шину не получили старые строки.
+    flash_cache_flush();
+
     return OK;
 }
 
 
 /**
- * @brief  Стирание сектора (SEGGER_FL_EraseSector).
- *         Стирает один сектор Flash по указанному адресу.
+ * @brief  Стирание секторов (SEGGER_FL_Erase).
+ *         Стирает NumSectors страниц, начиная с SectorAddr, за один вызов.
+ *
+ * @note   Если затронуто не меньше LOADER_FULL_ERASE_THRESHOLD страниц,
+ *         а остальная часть Flash уже чистая, вся область стирается одной
+ *         командой FLASH_EraseFull(): это быстрее постраничного стирания и
+ *         не затрагивает данные за пределами запрошенного диапазона.
+ *         Время стирания и число страниц накапливаются в g_LoaderStats.
  *
- * @param  SectorAddr: Адрес сектора (выровнен на размер сектора).
- * @param  SectorIndex: Индекс сектора
+ * @param  SectorAddr: Адрес первого сектора (выровнен на размер сектора).
+ * @param  SectorIndex: Индекс первого сектора
  * @param  NumSectors: Количество секторов
- * @return 0 - Успех.
+ * @return 0 - Успех, 1 - Диапазон выходит за пределы Flash.
  */
 SECTION_PRGCODE int EraseSector( uint32_t SectorAddr, uint32_t SectorIndex, uint32_t NumSectors )
 {
-    ( void ) NumSectors;
     ( void ) SectorIndex;
 
-    // Записываем адрес сектора.
-    FLASH_SetAddr( SectorAddr );
+    uint32_t First = ( SectorAddr - LOADER_BASE ) >> MEM_FLASH_PAGE_SIZE_LOG2;
+    uint32_t Last = First + NumSectors;
 
-    // Отправляем команду стирания сектора.
-    FLASH_SetCmd( FLASH_CMD_ERSEC_Msk, FLASH_Region_Main );
+    if ( First > LOADER_PAGE_TOTAL || NumSectors > LOADER_PAGE_TOTAL - First ) return ERROR;
 
-    // Даем время аппаратуре взвести флаг BUSY.
-    __NOP5();
+    uint64_t Start = mtimer_get_raw_time();
 
-    // Ждём завершения операции.
-    while ( FLASH_BusyStatus() ) {}
+    if ( NumSectors >= LOADER_FULL_ERASE_THRESHOLD &&
+         _IsRangeErased( LOADER_BASE, First << MEM_FLASH_PAGE_SIZE_LOG2 ) &&
+         _IsRangeErased( LOADER_BASE + ( Last << MEM_FLASH_PAGE_SIZE_LOG2 ),
+                         ( LOADER_PAGE_TOTAL - Last ) << MEM_FLASH_PAGE_SIZE_LOG2 ) )
+    {
+        FLASH_EraseFull( LOADER_REGION );
+
+        g_LoaderStats.FullErases++;
+    }
+    else
+    {
+        for ( uint32_t i = 0; i < NumSectors; i++ )
+        {
+            _ErasePage( SectorAddr + ( i << MEM_FLASH_PAGE_SIZE_LOG2 ) );
+        }
+    }
+
+    g_LoaderStats.ErasedPages += NumSectors;
+    g_LoaderStats.EraseTimeUs += ( uint32_t ) ( mtimer_get_raw_time() - Start ) / MTIME_CLOCKS_PER_USEC;
 
     return OK;
 }
@@ -97,6 +504,8 @@ SECTION_PRGCODE int EraseSector( uint32_t SectorAddr, uint32_t SectorIndex, uint
  *
  * @note   Контроллер К1921ВГ015 имеет буфер записи 128 бит (16 байт).
  *         J-Link будет вызывать эту функцию с размером, кратным FlashDevice.PageSize (16).
+ *         Чистые (0xFF) и уже совпадающие с Flash блоки не записываются,
+ *         их количество накапливается в g_LoaderStats.SkippedBlocks.
  *
  * @param  DestAddr: Адрес назначения (выровнен на 16 байт).
  * @param  NumBytes: Количество байт (кратно 16).
@@ -105,44 +514,101 @@ SECTION_PRGCODE int EraseSector( uint32_t SectorAddr, uint32_t SectorIndex, uint
  */
 SECTION_PRGCODE int ProgramPage( uint32_t DestAddr, uint32_t NumBytes, uint8_t* pSrcBuff )
 {
+    FlashBlock Block;
+
     // Цикл по 16 байт (размер аппаратного буфера записи)
     while ( NumBytes >= MEM_FLASH_BUS_WIDTH_WORDS )
     {
-        // Устанавливаем адрес.
-        FLASH_SetAddr( DestAddr );
+        // Пока контроллер пишет предыдущий блок, собираем следующий.
+        _FetchBlock( pSrcBuff, &Block );
 
-        // Заполняем 4 регистра данных (DATA[0]..DATA[3]).
-        // Внимание: pSrcBuff может быть не выровнен на 4 байта,
-        // поэтому собираем uint32_t вручную побайтно (Little Endian).
-        for ( int i = 0; i < MEM_FLASH_BUS_WIDTH_WORDS / sizeof( uint32_t ); i++ )
-        {
-            uint32_t val = 0;
+        _ProgramBlock( DestAddr, &Block );
+
+        // Переходим к следующему блоку.
+        DestAddr += MEM_FLASH_BUS_WIDTH_WORDS;
+        NumBytes -= MEM_FLASH_BUS_WIDTH_WORDS;
+        pSrcBuff += MEM_FLASH_BUS_WIDTH_WORDS;
+    }
+
+    // Ждём завершения последней записи.
+    while ( FLASH_BusyStatus() ) {}
 
-            val |= ( uint32_t ) pSrcBuff[0] << 0;
-            val |= ( uint32_t ) pSrcBuff[1] << 8;
-            val |= ( uint32_t ) pSrcBuff[2] << 16;
-            val |= ( uint32_t ) pSrcBuff[3] << 24;
+    return OK;
+}
 
-            FLASH_SetData( i, val );
 
-            pSrcBuff += 4;
+/**
+ * @brief  Программирование из RLE-потока.
+ *         Распаковывает поток сразу в 16-байтный буфер записи Flash.
+ *
+ * @note   Не является точкой входа J-Link: стандартная загрузка через
+ *         J-Link DLL всегда передаёт несжатые данные. Функцию вызывает
+ *         командный файл J-Link Commander, который создаёт
+ *         tools/rle_pack.py --jlink: он кладёт сжатые сектора в RAM
+ *         и вызывает EraseSector() и ProgramCompressed() для каждого
+ *         из них (см. README).
+ *
+ *         Формат записи: байт заголовка, бит 7 - признак повтора,
+ *         биты 6..0 - длина минус 1 (0x7F - длина задана следующими
+ *         двумя байтами, Little Endian). За заголовком повтора следует
+ *         один байт значения, за заголовком литерала - сами данные.
+ *         Распакованный размер должен быть кратен 16 байтам.
+ *
+ * @param  DestAddr: Адрес назначения (выровнен на 16 байт).
+ * @param  NumBytes: Размер сжатого потока.
+ * @param  pSrcBuff: Указатель на сжатый поток.
+ * @return 0 - Успех, 1 - Ошибка формата потока.
+ */
+SECTION_PRGCODE int ProgramCompressed( uint32_t DestAddr, uint32_t NumBytes, uint8_t* pSrcBuff )
+{
+    FlashBlock Block;
+
+    const uint8_t* pEnd = pSrcBuff + NumBytes;
+    uint32_t Fill = 0;
+
+    while ( pSrcBuff < pEnd )
+    {
+        uint32_t Header = *pSrcBuff++;
+        uint32_t Length = ( Header & RLE_LENGTH_Msk ) + 1;
+        uint8_t Value = 0;
+
+        if ( ( Header & RLE_LENGTH_Msk ) == RLE_LENGTH_EXT )
+        {
+            if ( pEnd - pSrcBuff < 2 ) return ERROR;
+
+            Length = pSrcBuff[0] | ( ( uint32_t ) pSrcBuff[1] << 8 );
+            pSrcBuff += 2;
         }
 
-        // Отправляем команду записи.
-        FLASH_SetCmd( FLASH_Cmd_Write, FLASH_Region_Main );
+        if ( Header & RLE_RUN_Msk )
+        {
+            if ( pSrcBuff >= pEnd ) return ERROR;
+
+            Value = *pSrcBuff++;
+        }
+        else if ( ( uint32_t ) ( pEnd - pSrcBuff ) < Length )
+        {
+            return ERROR;
+        }
 
-        // Даем время аппаратуре взвести флаг BUSY.
-        __NOP5();
+        while ( Length-- )
+        {
+            Block.Byte[Fill++] = ( Header & RLE_RUN_Msk ) ? Value : *pSrcBuff++;
 
-        // Ждём завершения операции.
-        while ( FLASH_BusyStatus() ) {}
+            if ( Fill == MEM_FLASH_BUS_WIDTH_WORDS )
+            {
+                _ProgramBlock( DestAddr, &Block );
 
-        // Переходим к следующему блоку.
-        DestAddr += MEM_FLASH_BUS_WIDTH_WORDS;
-        NumBytes -= MEM_FLASH_BUS_WIDTH_WORDS;
+                DestAddr += MEM_FLASH_BUS_WIDTH_WORDS;
+                Fill = 0;
+            }
+        }
     }
 
-    return OK;
+    // Ждём завершения последней записи.
+    while ( FLASH_BusyStatus() ) {}
+
+    return ( Fill == 0 ) ? OK : ERROR;
 }
 
 
@@ -152,12 +618,201 @@ SECTION_PRGCODE int ProgramPage( uint32_t DestAddr, uint32_t NumBytes, uint8_t*
  */
 SECTION_PRGCODE int EraseChip( void )
 {
-    FLASH_EraseFull( FLASH_Region_Main );
+    uint64_t Start = mtimer_get_raw_time();
+
+    FLASH_EraseFull( LOADER_REGION );
+
+    g_LoaderStats.ErasedPages += LOADER_PAGE_TOTAL;
+    g_LoaderStats.FullErases++;
+    g_LoaderStats.EraseTimeUs += ( uint32_t ) ( mtimer_get_raw_time() - Start ) / MTIME_CLOCKS_PER_USEC;
 
     return OK;
 }
 
 
+// -----------------------------------------------------------------------------
+// Опциональные функции SEGGER Flash Loader API
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief  Проверка на чистоту (SEGGER_FL_CheckBlank).
+ *         Позволяет J-Link пропускать стирание уже чистых секторов.
+ *
+ * @param  Addr: Начальный адрес.
+ * @param  NumBytes: Количество байт.
+ * @param  BlankData: Значение стертой ячейки.
+ * @return 0 - Область чистая, 1 - Область содержит данные.
+ */
+SECTION_PRGCODE int BlankCheck( uint32_t Addr, uint32_t NumBytes, uint8_t BlankData )
+{
+    FlashBlock Block;
+
+    uint32_t BlankWord = BlankData * 0x01010101UL;
+
+    while ( NumBytes > 0 )
+    {
+        uint32_t Offset = Addr & ( MEM_FLASH_BUS_WIDTH_WORDS - 1 );
+        uint32_t Count = MEM_FLASH_BUS_WIDTH_WORDS - Offset;
+
+        if ( Count > NumBytes ) Count = NumBytes;
+
+        _ReadBlock( Addr - Offset, &Block );
+
+        if ( Count == MEM_FLASH_BUS_WIDTH_WORDS )
+        {
+            // Полный блок сравниваем словами.
+            if ( ( Block.Word[0] ^ BlankWord ) | ( Block.Word[1] ^ BlankWord ) |
+                 ( Block.Word[2] ^ BlankWord ) | ( Block.Word[3] ^ BlankWord ) )
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            for ( uint32_t i = Offset; i < Offset + Count; i++ )
+            {
+                if ( Block.Byte[i] != BlankData ) return 1;
+            }
+        }
+
+        Addr += Count;
+        NumBytes -= Count;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief  Сравнение содержимого Flash с буфером (SEGGER_FL_Verify).
+ *
+ * @param  Addr: Начальный адрес.
+ * @param  NumBytes: Количество байт.
+ * @param  pBuff: Эталонные данные.
+ * @return Addr + NumBytes - Совпадение, иначе адрес первого несовпадающего байта.
+ */
+SECTION_PRGCODE uint32_t Verify( uint32_t Addr, uint32_t NumBytes, uint8_t* pBuff )
+{
+    FlashBlock Block;
+
+    while ( NumBytes > 0 )
+    {
+        uint32_t Offset = Addr & ( MEM_FLASH_BUS_WIDTH_WORDS - 1 );
+        uint32_t Count = MEM_FLASH_BUS_WIDTH_WORDS - Offset;
+
+        if ( Count > NumBytes ) Count = NumBytes;
+
+        _ReadBlock( Addr - Offset, &Block );
+
+        for ( uint32_t i = 0; i < Count; i++ )
+        {
+            if ( Block.Byte[Offset + i] != pBuff[i] ) return Addr + i;
+        }
+
+        pBuff += Count;
+        Addr += Count;
+        NumBytes -= Count;
+    }
+
+    return Addr;
+}
+
+
+/**
+ * @brief  Чтение Flash в буфер (SEGGER_FL_Read).
+ *
+ * @param  Addr: Начальный адрес.
+ * @param  NumBytes: Количество байт.
+ * @param  pDestBuff: Буфер назначения.
+ * @return Количество прочитанных байт.
+ */
+SECTION_PRGCODE int SEGGER_OPEN_Read( uint32_t Addr, uint32_t NumBytes, uint8_t* pDestBuff )
+{
+    FlashBlock Block;
+
+    uint32_t Total = NumBytes;
+
+    while ( NumBytes > 0 )
+    {
+        uint32_t Offset = Addr & ( MEM_FLASH_BUS_WIDTH_WORDS - 1 );
+        uint32_t Count = MEM_FLASH_BUS_WIDTH_WORDS - Offset;
+
+        if ( Count > NumBytes ) Count = NumBytes;
+
+        _ReadBlock( Addr - Offset, &Block );
+
+        for ( uint32_t i = 0; i < Count; i++ )
+        {
+            pDestBuff[i] = Block.Byte[Offset + i];
+        }
+
+        pDestBuff += Count;
+        Addr += Count;
+        NumBytes -= Count;
+    }
+
+    return ( int ) Total;
+}
+
+
+/**
+ * @brief  Расчёт CRC области Flash (SEGGER_FL_CalcCRC).
+ *         J-Link сравнивает результат с CRC образа и не перепрограммирует
+ *         совпадающие сектора.
+ *
+ * @note   Стандартный полином CRC-32 считается блоком CRC0,
+ *         прочие полиномы - программно.
+ *
+ * @param  CRC: Начальное значение CRC.
+ * @param  Addr: Начальный адрес.
+ * @param  NumBytes: Количество байт.
+ * @param  Polynom: Отражённый полином.
+ * @return Значение CRC.
+ */
+SECTION_PRGCODE uint32_t SEGGER_OPEN_CalcCRC( uint32_t CRC, uint32_t Addr, uint32_t NumBytes, uint32_t Polynom )
+{
+    FlashBlock Block;
+
+    int UseHw = ( Polynom == CRC32_POLY_REFLECTED );
+
+    if ( UseHw ) _CRC0Start( CRC );
+
+    while ( NumBytes > 0 )
+    {
+        uint32_t Offset = Addr & ( MEM_FLASH_BUS_WIDTH_WORDS - 1 );
+        uint32_t Count = MEM_FLASH_BUS_WIDTH_WORDS - Offset;
+
+        if ( Count > NumBytes ) Count = NumBytes;
+
+        _ReadBlock( Addr - Offset, &Block );
+
+        if ( UseHw && Count == MEM_FLASH_BUS_WIDTH_WORDS )
+        {
+            CRC_SetData( CRC0, Block.Word[0] );
+            CRC_SetData( CRC0, Block.Word[1] );
+            CRC_SetData( CRC0, Block.Word[2] );
+            CRC_SetData( CRC0, Block.Word[3] );
+        }
+        else if ( UseHw )
+        {
+            // Неполный блок (начало или конец области) досчитываем программно.
+            CRC = _CalcCRCSoft( CRC_GetData( CRC0 ), &Block.Byte[Offset], Count, Polynom );
+
+            _CRC0Start( CRC );
+        }
+        else
+        {
+            CRC = _CalcCRCSoft( CRC, &Block.Byte[Offset], Count, Polynom );
+        }
+
+        Addr += Count;
+        NumBytes -= Count;
+    }
+
+    return UseHw ? CRC_GetData( CRC0 ) : CRC;
+}
+
+
 // -----------------------------------------------------------------------------
 // Описание устройства
 // -----------------------------------------------------------------------------
@@ -169,18 +824,18 @@ SECTION_PRGCODE int EraseChip( void )
 SECTION_DEVDSCR const DeviceInfo FlashDevice =
 {
     ALGO_VERSION,              // Версия алгоритма (0x0101)
-    "K1921VG015 Internal",     // Имя устройства (отображается в J-Link)
+    LOADER_DEVICE_NAME,        // Имя устройства (отображается в J-Link)
     ONCHIP,                    // Тип (1 = On-chip Flash)
-    MEM_FLASH_BASE,            // Базовый адрес: 0x80000000
-    MEM_FLASH_SIZE,            // Полный размер: 1 МБ (0x100000)
+    LOADER_BASE,               // Базовый адрес: 0x80000000 (NVR: 0x80200000)
+    LOADER_SIZE,               // Полный размер: 1 МБ (NVR: 8 КБ)
     2048,                      // Размер страницы программирования
     0,                         // Зарезервировано
-    0xFF,                      // Значение стертой ячейки
+    FLASH_ERASED_VALUE,        // Значение стертой ячейки
     20,                        // Таймаут записи страницы (мс)
     400,                       // Таймаут стирания сектора (мс)
     // Карта секторов
     {
-        { MEM_FLASH_PAGE_SIZE, 0x00000000 },    // Сектор 0: 256 x 4 КБ
+        { MEM_FLASH_PAGE_SIZE, 0x00000000 },    // Сектор 0: 256 x 4 КБ (NVR: 2 x 4 КБ)
         { 0xFFFFFFFF, 0xFFFFFFFF }              // Маркер конца таблицы
     }
 };
@@ -200,15 +855,13 @@ __attribute__( ( section( "PrgCodeTable" ) ) ) void ( *const g_pFuncs[] )( void
     ( void ( * )( void ) ) UnInit,
     ( void ( * )( void ) ) EraseSector,
     ( void ( * )( void ) ) ProgramPage,
-    ( void ( * )( void ) ) 0,
-    ( void ( * )( void ) ) EraseChip
+    ( void ( * )( void ) ) BlankCheck,          // Optional (SEGGER_FL_CheckBlank)
+    ( void ( * )( void ) ) EraseChip,           // Optional (SEGGER_FL_EraseChip)
+    ( void ( * )( void ) ) Verify,              // Optional (SEGGER_FL_Verify)
+    ( void ( * )( void ) ) SEGGER_OPEN_CalcCRC, // Optional (SEGGER_FL_CalcCRC)
+    ( void ( * )( void ) ) SEGGER_OPEN_Read     // Optional (SEGGER_FL_Read)
 
     // Опциональные функции не реализованы.
-    // (void (*)(void))Verify,     // Optional (SEGGER_FL_Verify)
-    // (void (*)(void))EraseChip,  // Optional (SEGGER_FL_EraseChip)
-    // (void (*)(void))CheckBlank, // Optional (SEGGER_FL_CheckBlank)
-    // (void (*)(void))Read,       // Optional (SEGGER_FL_Read)
-    // (void (*)(void))CalcCRC,    // Optional (SEGGER_FL_CalcCRC)
     // (void (*)(void))Start,      // Optional (SEGGER_FL_Start)
     // (void (*)(void))GetInfo     // Optional (SEGGER_FL_GetFlashInfo)
 };
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""
+RLE-упаковщик образа для ProgramCompressed() (см. src/loader.c).
+
+Образ (ELF или BIN) разбивается на сектора Flash по 4 КБ. Полностью чистые
+сектора (0xFF) пропускаются, остальные сжимаются независимо друг от друга,
+чтобы каждый сектор можно было передать одним вызовом ProgramCompressed().
+
+Формат выходного файла - последовательность записей:
+    uint32_t DestAddr;   // Адрес сектора
+    uint32_t Size;       // Размер сжатого потока
+    uint8_t  Data[Size]; // RLE-поток
+
+С ключом --jlink дополнительно создаётся командный файл J-Link Commander,
+который загружает segger-flash-loader.elf и сжатые сектора в RAM и вызывает
+EraseSector() и ProgramCompressed() для каждого сектора (см. README).
+
+Примеры:
+    python rle_pack.py build/Release/01-default.elf -o 01-default.rle
+    python rle_pack.py firmware.bin --base 0x80000000 --stats
+    python rle_pack.py build/Release/01-default.elf --jlink 01-default.jlink \
+        --loader ../segger-flash-loader/build/Release/segger-flash-loader.elf
+"""
+
+import argparse
+import struct
+import sys
+
+FLASH_BASE = 0x80000000
+FLASH_SIZE = 0x100000
+SECTOR_SIZE = 4096
+BLOCK_SIZE = 16
+ERASED = 0xFF
+
+RLE_RUN = 0x80
+RLE_LENGTH_EXT = 0x7F
+RLE_MAX_LENGTH = 0xFFFF
+
+# Минимальная длина повтора, при которой он выгоднее литерала.
+MIN_RUN = 3
+
+# Размещение в RAM0 для командного файла J-Link (--jlink). Загрузчик занимает
+# рабочую область 0x40000000..0x40007FFF (loader.ld), выше лежат стек,
+# адрес возврата (на нём стоит точка останова) и буфер сжатых секторов.
+JLINK_STACK_TOP = 0x4000FFF0
+JLINK_RETURN_ADDR = 0x4000FFF0
+JLINK_BUFFER_ADDR = 0x40010000
+JLINK_BUFFER_SIZE = 0x30000
+JLINK_TIMEOUT_MS = 2000
+
+# Коды функций для Init()/UnInit() (SEGGER Flash Loader API).
+FUNC_PROGRAM = 2
+
+
+def load_elf(path):
+    """Возвращает список (адрес, данные) загружаемых сегментов ELF32 LE."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("поддерживается только ELF32 Little Endian")
+
+    e_phoff, = struct.unpack_from("<I", data, 0x1C)
+    e_phentsize, e_phnum = struct.unpack_from("<HH", data, 0x2A)
+
+    segments = []
+
+    for i in range(e_phnum):
+        p_type, p_offset, _, p_paddr, p_filesz = struct.unpack_from("<IIIII", data, e_phoff + i * e_phentsize)
+
+        # PT_LOAD с данными в файле.
+        if p_type == 1 and p_filesz:
+            segments.append((p_paddr, data[p_offset:p_offset + p_filesz]))
+
+    return segments
+
+
+def load_elf_symbols(path):
+    """Возвращает словарь {имя: адрес} из таблицы символов ELF32 LE."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("поддерживается только ELF32 Little Endian")
+
+    e_shoff, = struct.unpack_from("<I", data, 0x20)
+    e_shentsize, e_shnum = struct.unpack_from("<HH", data, 0x2E)
+
+    sections = [struct.unpack_from("<IIIIIIIIII", data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+    symbols = {}
+
+    for sh_name, sh_type, _, _, sh_offset, sh_size, sh_link, _, _, _ in sections:
+        # SHT_SYMTAB
+        if sh_type != 2:
+            continue
+
+        str_offset = sections[sh_link][4]
+
+        for i in range(sh_size // 16):
+            st_name, st_value = struct.unpack_from("<II", data, sh_offset + i * 16)
+            end = data.index(b"\0", str_offset + st_name)
+            symbols[data[str_offset + st_name:end].decode()] = st_value
+
+    return symbols
+
+
+def build_image(segments):
+    """Собирает образ Flash, заполняя пропуски стертым значением."""
+    image = bytearray([ERASED]) * FLASH_SIZE
+    top = 0
+
+    for addr, chunk in segments:
+        offset = addr - FLASH_BASE
+
+        if offset < 0 or offset + len(chunk) > FLASH_SIZE:
+            continue
+
+        image[offset:offset + len(chunk)] = chunk
+        top = max(top, offset + len(chunk))
+
+    # Выравниваем конец образа на 16 байт (буфер записи Flash).
+    top = (top + BLOCK_SIZE - 1) // BLOCK_SIZE * BLOCK_SIZE
+
+    return image[:top]
+
+
+def _header(run, length):
+    if length <= RLE_LENGTH_EXT:
+        return bytes([(RLE_RUN if run else 0) | (length - 1)])
+
+    return bytes([(RLE_RUN if run else 0) | RLE_LENGTH_EXT]) + struct.pack("<H", length)
+
+
+def compress(data):
+    out = bytearray()
+    literal_start = 0
+    i = 0
+    n = len(data)
+
+    def flush_literal(end):
+        start = literal_start
+
+        while start < end:
+            length = min(end - start, RLE_MAX_LENGTH)
+            out.extend(_header(False, length))
+            out.extend(data[start:start + length])
+            start += length
+
+    while i < n:
+        j = i + 1
+
+        while j < n and data[j] == data[i] and j - i < RLE_MAX_LENGTH:
+            j += 1
+
+        if j - i >= MIN_RUN:
+            flush_literal(i)
+            out.extend(_header(True, j - i))
+            out.append(data[i])
+            literal_start = j
+
+        i = j
+
+    flush_literal(n)
+
+    return bytes(out)
+
+
+def decompress(stream):
+    """Эталонный распаковщик, повторяющий ProgramCompressed()."""
+    out = bytearray()
+    i = 0
+
+    while i < len(stream):
+        header = stream[i]
+        i += 1
+        length = (header & RLE_LENGTH_EXT) + 1
+
+        if header & RLE_LENGTH_EXT == RLE_LENGTH_EXT:
+            length, = struct.unpack_from("<H", stream, i)
+            i += 2
+
+        if header & RLE_RUN:
+            out.extend(bytes([stream[i]]) * length)
+            i += 1
+        else:
+            out.extend(stream[i:i + length])
+            i += length
+
+    return bytes(out)
+
+
+def _jlink_call(lines, comment, func, *args):
+    """Вызов функции загрузчика: аргументы в a0..a2, возврат на точку останова."""
+    lines.append("// %s" % comment)
+
+    for i, value in enumerate(args):
+        lines.append("wreg x%d, 0x%08X" % (10 + i, value))
+
+    lines.append("wreg x1, 0x%08X" % JLINK_RETURN_ADDR)
+    lines.append("wreg x2, 0x%08X" % JLINK_STACK_TOP)
+    lines.append("setpc 0x%08X" % func)
+    lines.append("g")
+    lines.append("WaitHalt %d" % JLINK_TIMEOUT_MS)
+    # Результат (0 - успех) выводится в журнал J-Link Commander.
+    lines.append("rreg x10")
+
+
+def write_jlink_script(path, loader_path, records):
+    """
+    Командный файл J-Link Commander для прошивки сжатыми секторами.
+
+    records - список (DestAddr, RLE-поток). Потоки загружаются в RAM пачками
+    по JLINK_BUFFER_SIZE байт, для каждой пачки создаётся файл <path>.<n>.bin.
+    """
+    symbols = load_elf_symbols(loader_path)
+
+    for name in ("Init", "UnInit", "EraseSector", "ProgramCompressed"):
+        if name not in symbols:
+            raise ValueError("в %s нет символа %s" % (loader_path, name))
+
+    lines = [
+        "// Создан rle_pack.py, запуск:",
+        "// JLink -device K1921VG015 -if JTAG -speed 4000 -autoconnect 1 -CommandFile %s" % path,
+        "r",
+        "h",
+        "loadfile %s" % loader_path,
+        "setbp 0x%08X" % JLINK_RETURN_ADDR,
+    ]
+
+    _jlink_call(lines, "Init()", symbols["Init"], FLASH_BASE, 0, FUNC_PROGRAM)
+
+    batch = bytearray()
+    batch_calls = []
+    batch_index = 0
+
+    def flush_batch():
+        nonlocal batch, batch_calls, batch_index
+
+        if not batch_calls:
+            return
+
+        bin_path = "%s.%d.bin" % (path, batch_index)
+
+        with open(bin_path, "wb") as f:
+            f.write(batch)
+
+        lines.append("loadbin %s, 0x%08X" % (bin_path, JLINK_BUFFER_ADDR))
+        lines.extend(batch_calls)
+
+        batch = bytearray()
+        batch_calls = []
+        batch_index += 1
+
+    for addr, stream in records:
+        if len(batch) + len(stream) > JLINK_BUFFER_SIZE:
+            flush_batch()
+
+        sector = (addr - FLASH_BASE) // SECTOR_SIZE
+        calls = []
+
+        _jlink_call(calls, "EraseSector(0x%08X)" % addr, symbols["EraseSector"], addr, sector, 1)
+        _jlink_call(calls, "ProgramCompressed(0x%08X, %d)" % (addr, len(stream)), symbols["ProgramCompressed"],
+                    addr, len(stream), JLINK_BUFFER_ADDR + len(batch))
+
+        batch_calls.extend(calls)
+        batch.extend(stream)
+
+        # Следующий поток начинается с границы слова.
+        batch.extend(bytes(-len(batch) % 4))
+
+    flush_batch()
+
+    _jlink_call(lines, "UnInit()", symbols["UnInit"], FUNC_PROGRAM)
+
+    lines.extend([
+        "clrbp",
+        "r",
+        "g",
+        "q",
+    ])
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RLE-упаковка образа для ProgramCompressed()")
+    parser.add_argument("input", help="ELF или BIN файл")
+    parser.add_argument("-o", "--output", help="выходной файл с записями (DestAddr, Size, Data)")
+    parser.add_argument("--base", type=lambda x: int(x, 0), default=FLASH_BASE,
+                        help="адрес загрузки BIN файла (по умолчанию 0x80000000)")
+    parser.add_argument("--bin", action="store_true", help="считать вход BIN файлом, даже если это ELF")
+    parser.add_argument("--stats", action="store_true", help="вывести сравнение объёмов передачи")
+    parser.add_argument("--jlink", metavar="SCRIPT", help="создать командный файл J-Link Commander")
+    parser.add_argument("--loader", metavar="ELF", help="собранный segger-flash-loader.elf (для --jlink)")
+    args = parser.parse_args()
+
+    if args.jlink and not args.loader:
+        parser.error("для --jlink нужен --loader")
+
+    with open(args.input, "rb") as f:
+        is_elf = f.read(4) == b"\x7fELF" and not args.bin
+
+    if is_elf:
+        segments = load_elf(args.input)
+    else:
+        with open(args.input, "rb") as f:
+            segments = [(args.base, f.read())]
+
+    image = build_image(segments)
+
+    records = bytearray()
+    streams = []
+    raw_size = 0
+    packed_size = 0
+    sectors = 0
+    skipped = 0
+
+    for offset in range(0, len(image), SECTOR_SIZE):
+        sector = image[offset:offset + SECTOR_SIZE]
+
+        if sector.count(ERASED) == len(sector):
+            skipped += 1
+            continue
+
+        stream = compress(sector)
+
+        if decompress(stream) != sector:
+            sys.exit("ошибка: распакованный сектор 0x%08X не совпадает с исходным" % (FLASH_BASE + offset))
+
+        records.extend(struct.pack("<II", FLASH_BASE + offset, len(stream)))
+        records.extend(stream)
+        streams.append((FLASH_BASE + offset, stream))
+
+        raw_size += len(sector)
+        packed_size += len(stream)
+        sectors += 1
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(records)
+
+    if args.jlink:
+        write_jlink_script(args.jlink, args.loader, streams)
+
+    if args.stats or not (args.output or args.jlink):
+        print("Образ:            %d байт (0x%08X..0x%08X)" % (len(image), FLASH_BASE, FLASH_BASE + len(image)))
+        print("Сектора:          %d записываемых, %d чистых пропущено" % (sectors, skipped))
+        print("Передача (raw):   %d байт" % len(image))
+        print("Передача (RLE):   %d байт (%d заголовков записей)" % (packed_size + 8 * sectors, sectors))
+
+        if len(image):
+            print("Сжатие:           %.1f%%" % (100.0 * (packed_size + 8 * sectors) / len(image)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,260 @@
+/** Host test and write-path benchmark of segger-flash-loader/src/loader.c.
+ *
+ * loader.c is built unchanged against flash_model.h. The same test is built
+ * for the main region, the NVR region (LOADER_NVR) and with DATA loading
+ * overlapped with BUSY (LOADER_DATA_OVERLAP).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_model.h"
+#include "FlashOS.h"
+
+int Init(uint32_t Addr, uint32_t Freq, uint32_t Func);
+int UnInit(uint32_t Func);
+int EraseSector(uint32_t SectorAddr, uint32_t SectorIndex, uint32_t NumSectors);
+int ProgramPage(uint32_t DestAddr, uint32_t NumBytes, uint8_t *pSrcBuff);
+int ProgramCompressed(uint32_t DestAddr, uint32_t NumBytes, uint8_t *pSrcBuff);
+int EraseChip(void);
+int BlankCheck(uint32_t Addr, uint32_t NumBytes, uint8_t BlankData);
+uint32_t Verify(uint32_t Addr, uint32_t NumBytes, uint8_t *pBuff);
+int SEGGER_OPEN_Read(uint32_t Addr, uint32_t NumBytes, uint8_t *pDestBuff);
+uint32_t SEGGER_OPEN_CalcCRC(uint32_t CRC, uint32_t Addr, uint32_t NumBytes, uint32_t Polynom);
+
+extern const DeviceInfo FlashDevice;
+
+#ifdef LOADER_NVR
+#define TEST_REGION FLASH_Region_NVR
+#define TEST_SIZE   MEM_FLASH_NVR_SIZE
+#else
+#define TEST_REGION FLASH_Region_Main
+#define TEST_SIZE   (64 * 1024)
+#endif
+
+#define CRC32C_POLY_REFLECTED 0x82F63B78UL
+
+static int failures;
+
+#define CHECK(COND)                                                      \
+    do {                                                                 \
+        if (!(COND)) {                                                   \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,       \
+                    __LINE__, #COND);                                    \
+            failures++;                                                  \
+        }                                                                \
+    } while (0)
+
+static uint8_t image[TEST_SIZE + 1];
+static uint8_t readback[TEST_SIZE];
+
+static uint32_t base(void)
+{
+    return FlashDevice.BaseAddr;
+}
+
+static void make_image(uint8_t *dst, uint32_t size, unsigned erased_percent, unsigned seed)
+{
+    srand(seed);
+
+    for (uint32_t blk = 0; blk < size; blk += MEM_FLASH_BUS_WIDTH_WORDS) {
+        int erased = (unsigned)(rand() % 100) < erased_percent;
+
+        for (uint32_t i = 0; i < MEM_FLASH_BUS_WIDTH_WORDS; i++) {
+            dst[blk + i] = erased ? 0xFF : (uint8_t)rand();
+        }
+    }
+}
+
+static uint32_t crc_soft(uint32_t crc, const uint8_t *data, uint32_t size, uint32_t poly)
+{
+    while (size--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static void check_protocol(void)
+{
+    CHECK(flash_model.cmd_while_busy == 0);
+    CHECK(flash_model.data_read_while_busy == 0);
+    CHECK(flash_model.bad_addr == 0);
+}
+
+/** Program the image through the loader, return core clocks spent.
+ */
+static uint64_t program(uint8_t *src, uint32_t size)
+{
+    uint64_t start = flash_model.now;
+
+    // J-Link hands over the data in pieces of FlashDevice.PageSize.
+    for (uint32_t off = 0; off < size; off += FlashDevice.PageSize) {
+        uint32_t n = size - off < FlashDevice.PageSize ? size - off : FlashDevice.PageSize;
+
+        CHECK(ProgramPage(base() + off, n, src + off) == 0);
+    }
+
+    return flash_model.now - start;
+}
+
+static void test_program_verify(int unaligned)
+{
+    uint8_t *src = image + unaligned;
+
+    flash_model_reset();
+    Init(base(), 0, 2);
+    CHECK(EraseChip() == 0);
+
+    make_image(src, TEST_SIZE, 25, 1);
+    program(src, TEST_SIZE);
+    UnInit(2);
+
+    CHECK(memcmp(flash_model_mem(TEST_REGION, 0), src, TEST_SIZE) == 0);
+    CHECK(Verify(base(), TEST_SIZE, src) == base() + TEST_SIZE);
+    CHECK(SEGGER_OPEN_Read(base() + 3, TEST_SIZE - 3, readback) == TEST_SIZE - 3);
+    CHECK(memcmp(readback, src + 3, TEST_SIZE - 3) == 0);
+    CHECK(SEGGER_OPEN_CalcCRC(0xFFFFFFFF, base() + 5, TEST_SIZE - 9, CRC32C_POLY_REFLECTED) ==
+          crc_soft(0xFFFFFFFF, src + 5, TEST_SIZE - 9, CRC32C_POLY_REFLECTED));
+
+    // A single changed byte is reported at its address.
+    src[100] ^= 0x01;
+    CHECK(Verify(base(), TEST_SIZE, src) == base() + 100);
+    src[100] ^= 0x01;
+
+    CHECK(flash_model.cache_flushes > 0);
+    check_protocol();
+}
+
+static void test_erase_blank(void)
+{
+    flash_model_reset();
+    Init(base(), 0, 1);
+
+    make_image(image, TEST_SIZE, 0, 2);
+    program(image, TEST_SIZE);
+
+    CHECK(BlankCheck(base(), TEST_SIZE, 0xFF) == 1);
+    CHECK(EraseSector(base() + MEM_FLASH_PAGE_SIZE, 1, 1) == 0);
+    CHECK(BlankCheck(base() + MEM_FLASH_PAGE_SIZE, MEM_FLASH_PAGE_SIZE, 0xFF) == 0);
+    CHECK(BlankCheck(base(), MEM_FLASH_PAGE_SIZE, 0xFF) == 1);
+    CHECK(flash_model.page_erases == 1);
+
+    // A range outside the region is rejected.
+    CHECK(EraseSector(base() + FlashDevice.TotalSize, 0, 1) != 0);
+
+    check_protocol();
+}
+
+/** Programming the same image twice must not corrupt it.
+ */
+static void test_reprogram(void)
+{
+    flash_model_reset();
+    Init(base(), 0, 2);
+
+    make_image(image, TEST_SIZE, 25, 3);
+    program(image, TEST_SIZE);
+    program(image, TEST_SIZE);
+
+    CHECK(Verify(base(), TEST_SIZE, image) == base() + TEST_SIZE);
+    check_protocol();
+}
+
+/** RLE stream as produced by tools/rle_pack.py: literal, extended run,
+ * short run. Malformed streams are rejected.
+ */
+static void test_compressed(void)
+{
+    uint8_t stream[] = {
+        0x04, 1, 2, 3, 4, 5,            // 5 literal bytes
+        0xFF, 200, 0, 0xFF,             // 200 x 0xFF, extended length
+        0x80 | 18, 0xAA,                // 19 x 0xAA
+    };
+    uint8_t expect[224];
+
+    memcpy(expect, "\x01\x02\x03\x04\x05", 5);
+    memset(expect + 5, 0xFF, 200);
+    memset(expect + 205, 0xAA, 19);
+
+    flash_model_reset();
+    Init(base(), 0, 2);
+
+    CHECK(ProgramCompressed(base() + MEM_FLASH_PAGE_SIZE, sizeof(stream), stream) == 0);
+    CHECK(memcmp(flash_model_mem(TEST_REGION, MEM_FLASH_PAGE_SIZE), expect, sizeof(expect)) == 0);
+    CHECK(flash_model_mem(TEST_REGION, MEM_FLASH_PAGE_SIZE)[sizeof(expect)] == 0xFF);
+
+    // Truncated extended length, truncated literal, size not a multiple of 16.
+    CHECK(ProgramCompressed(base(), 2, (uint8_t[]){ 0x7F, 0x10 }) != 0);
+    CHECK(ProgramCompressed(base(), 3, (uint8_t[]){ 0x04, 1, 2 }) != 0);
+    CHECK(ProgramCompressed(base(), 2, (uint8_t[]){ 0x80 | 14, 0 }) != 0);
+
+    check_protocol();
+}
+
+/** If the controller sampled DATA at the end of a write instead of at the
+ * command, loading DATA during BUSY would corrupt the previous block. The
+ * default write path must be immune, the overlapped one must be caught by
+ * Verify (which J-Link runs after programming).
+ */
+static void test_late_latch(void)
+{
+    flash_model_reset();
+    flash_model.late_latch = 1;
+    Init(base(), 0, 2);
+
+    make_image(image, TEST_SIZE, 0, 4);
+    program(image, TEST_SIZE);
+    flash_model_settle();
+
+#ifdef LOADER_DATA_OVERLAP
+    CHECK(Verify(base(), TEST_SIZE, image) != base() + TEST_SIZE);
+#else
+    CHECK(Verify(base(), TEST_SIZE, image) == base() + TEST_SIZE);
+    CHECK(flash_model.data_writes_busy == 0);
+#endif
+}
+
+static void bench(const char *name, unsigned erased_percent)
+{
+    flash_model_reset();
+    Init(base(), 0, 2);
+
+    make_image(image, TEST_SIZE, erased_percent, 5);
+
+    uint64_t cycles = program(image, TEST_SIZE);
+
+    printf("  %-24s %8llu clocks/KB  writes %5u  reads %5u  DATA-under-BUSY %5u\n", name,
+           (unsigned long long)(cycles * 1024 / TEST_SIZE), (unsigned)flash_model.writes,
+           (unsigned)flash_model.reads, (unsigned)flash_model.data_writes_busy);
+}
+
+int main(void)
+{
+    test_program_verify(0);
+    test_program_verify(1);
+    test_erase_blank();
+    test_reprogram();
+    test_compressed();
+    test_late_latch();
+
+    printf("%s write path, model: reg %u, read %u, write %u clocks\n", (const char *)FlashDevice.Name,
+           FLASH_MODEL_REG_CYCLES, FLASH_MODEL_READ_CYCLES, FLASH_MODEL_WRITE_CYCLES);
+    bench("erased flash, 0% blank", 0);
+    bench("erased flash, 25% blank", 25);
+
+    // Unchanged image on already programmed flash.
+    uint64_t start = flash_model.now;
+    program(image, TEST_SIZE);
+    printf("  %-24s %8llu clocks/KB\n", "same image again",
+           (unsigned long long)((flash_model.now - start) * 1024 / TEST_SIZE));
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
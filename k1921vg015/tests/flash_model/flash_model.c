@@ -0,0 +1,196 @@
+#include <string.h>
+
+#include "flash_model.h"
+#include "flash_timing.h"
+#include "mtimer.h"
+
+flash_model_t flash_model;
+
+RCU_TypeDef flash_model_rcu;
+CRC_TypeDef flash_model_crc0;
+
+uint8_t *flash_model_mem(FLASH_Region_TypeDef region, uint32_t addr)
+{
+    if (region == FLASH_Region_NVR) {
+        return addr < MEM_FLASH_NVR_SIZE ? &flash_model.nvr[addr] : NULL;
+    }
+
+    return addr < MEM_FLASH_SIZE ? &flash_model.main[addr] : NULL;
+}
+
+static void flash_model_complete(void)
+{
+    uint32_t cmd = flash_model.pending_cmd;
+    FLASH_Region_TypeDef region = (FLASH_Region_TypeDef)(cmd & FLASH_CMD_NVRON_Msk);
+    uint32_t addr = flash_model.pending_addr;
+
+    flash_model.pending_cmd = 0;
+
+    if ((cmd & (FLASH_CMD_ERSEC_Msk | FLASH_CMD_ALLSEC_Msk)) == (FLASH_CMD_ERSEC_Msk | FLASH_CMD_ALLSEC_Msk)) {
+        if (region == FLASH_Region_NVR) {
+            memset(flash_model.nvr, 0xFF, sizeof(flash_model.nvr));
+        } else {
+            memset(flash_model.main, 0xFF, sizeof(flash_model.main));
+        }
+        return;
+    }
+
+    uint8_t *mem = flash_model_mem(region, addr);
+
+    if (mem == NULL) {
+        flash_model.bad_addr++;
+        return;
+    }
+
+    if (cmd & FLASH_CMD_ERSEC_Msk) {
+        memset(mem - (addr & (MEM_FLASH_PAGE_SIZE - 1)), 0xFF, MEM_FLASH_PAGE_SIZE);
+    } else if (cmd & FLASH_CMD_WR_Msk) {
+        const uint32_t *src = flash_model.late_latch ? flash_model.data : flash_model.latched;
+
+        mem -= addr & (MEM_FLASH_BUS_WIDTH_WORDS - 1);
+
+        // Programming can only clear bits.
+        for (uint32_t i = 0; i < MEM_FLASH_BUS_WIDTH_WORDS; i++) {
+            mem[i] &= (uint8_t)(src[i / 4] >> (8 * (i % 4)));
+        }
+    } else if (cmd & FLASH_CMD_RD_Msk) {
+        mem -= addr & (MEM_FLASH_BUS_WIDTH_WORDS - 1);
+
+        for (uint32_t i = 0; i < 4; i++) {
+            flash_model.data[i] = (uint32_t)mem[4 * i] | ((uint32_t)mem[4 * i + 1] << 8) |
+                                  ((uint32_t)mem[4 * i + 2] << 16) | ((uint32_t)mem[4 * i + 3] << 24);
+        }
+    }
+}
+
+/** One register access: advance the clock and retire a finished command.
+ */
+static void flash_model_access(void)
+{
+    flash_model.now += FLASH_MODEL_REG_CYCLES;
+
+    if (flash_model.pending_cmd && flash_model.now >= flash_model.busy_until) {
+        flash_model_complete();
+    }
+}
+
+static int flash_model_busy(void)
+{
+    return flash_model.pending_cmd != 0;
+}
+
+void flash_model_reset(void)
+{
+    memset(&flash_model, 0, sizeof(flash_model));
+    memset(flash_model.main, 0xFF, sizeof(flash_model.main));
+    memset(flash_model.nvr, 0xFF, sizeof(flash_model.nvr));
+}
+
+void flash_model_settle(void)
+{
+    if (flash_model.pending_cmd) {
+        flash_model.now = flash_model.busy_until;
+        flash_model_complete();
+    }
+}
+
+void FLASH_SetAddr(uint32_t AddrVal)
+{
+    flash_model_access();
+    flash_model.addr = AddrVal;
+}
+
+void FLASH_SetData(uint32_t DataNum, uint32_t DataVal)
+{
+    flash_model_access();
+
+    if (flash_model_busy() && (flash_model.pending_cmd & FLASH_CMD_WR_Msk)) {
+        flash_model.data_writes_busy++;
+    }
+
+    flash_model.data[DataNum & 3] = DataVal;
+}
+
+uint32_t FLASH_GetData(uint32_t DataNum)
+{
+    flash_model_access();
+
+    if (flash_model_busy()) {
+        flash_model.data_read_while_busy++;
+        return 0xDEADBEEF;
+    }
+
+    return flash_model.data[DataNum & 3];
+}
+
+void FLASH_SetCmd(FLASH_Cmd_TypeDef Cmd, FLASH_Region_TypeDef Region)
+{
+    uint64_t duration;
+
+    flash_model_access();
+
+    if (flash_model_busy()) {
+        flash_model.cmd_while_busy++;
+        return;
+    }
+
+    switch (Cmd) {
+    case FLASH_Cmd_Read:
+        duration = FLASH_MODEL_READ_CYCLES;
+        flash_model.reads++;
+        break;
+    case FLASH_Cmd_Write:
+        duration = FLASH_MODEL_WRITE_CYCLES;
+        memcpy(flash_model.latched, flash_model.data, sizeof(flash_model.latched));
+        flash_model.writes++;
+        break;
+    case FLASH_Cmd_ErasePage:
+        duration = FLASH_MODEL_ERASE_PAGE_CYCLES;
+        flash_model.page_erases++;
+        break;
+    default:
+        duration = FLASH_MODEL_ERASE_FULL_CYCLES;
+        flash_model.full_erases++;
+        break;
+    }
+
+    flash_model.pending_cmd = (uint32_t)Cmd | (uint32_t)Region;
+    flash_model.pending_addr = flash_model.addr;
+    flash_model.busy_until = flash_model.now + duration;
+}
+
+FlagStatus FLASH_BusyStatus(void)
+{
+    flash_model_access();
+
+    return flash_model_busy() ? SET : CLEAR;
+}
+
+void FLASH_EraseFull(FLASH_Region_TypeDef Region)
+{
+    FLASH_SetCmd(FLASH_Cmd_EraseFull, Region);
+
+    while (FLASH_BusyStatus()) {
+    }
+}
+
+void flash_cache_flush(void)
+{
+    flash_model_access();
+    flash_model.cache_flushes++;
+}
+
+// Services of the device support package used by the loader.
+
+void SystemInit(void)
+{
+}
+
+void SystemCoreClockUpdate(void)
+{
+}
+
+uint64_t mtimer_get_raw_time(void)
+{
+    return flash_model.now;
+}
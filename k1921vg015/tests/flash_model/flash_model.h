@@ -0,0 +1,136 @@
+#ifndef FLASH_MODEL_H
+#define FLASH_MODEL_H
+
+/** Host model of the K1921VG015 FLASH controller for the loader tests.
+ *
+ * The header is force-included (-include) into loader.c. It pulls in the
+ * real register layout and plib headers, but takes the place of
+ * plib015_flash.h: the FLASH_* calls of the loader go to a behavioural model
+ * with a cycle clock instead of the register block at 0x3000D000. RCU and
+ * CRC0 are redirected to plain structures in host memory. flash_model.c also
+ * provides flash_cache_flush() of flash_timing.c, which only counts flushes.
+ *
+ * Timing is counted in core clocks. Only the controller side is modelled:
+ * every register access costs FLASH_MODEL_REG_CYCLES, a command keeps BUSY
+ * set for its duration. Instructions executed by the loader between register
+ * accesses are not counted, so the numbers are a lower bound for the real
+ * loader and are meant for comparing write strategies, not as absolute
+ * throughput.
+ */
+
+#include <stdint.h>
+
+#include "K1921VG015.h"
+
+// The model replaces the inline register accessors of plib015_flash.h.
+#define __PLIB015_FLASH_H
+#include "plib015.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cost of one peripheral register access (AHB/APB round trip), core clocks.
+#ifndef FLASH_MODEL_REG_CYCLES
+#define FLASH_MODEL_REG_CYCLES 2
+#endif
+
+// Duration of a read command, core clocks.
+#ifndef FLASH_MODEL_READ_CYCLES
+#define FLASH_MODEL_READ_CYCLES 8
+#endif
+
+// Duration of a 128-bit write: the manual gives no figure, 10 us at 50 MHz is
+// assumed (typical for embedded NOR flash). Override to re-run the benchmark.
+#ifndef FLASH_MODEL_WRITE_CYCLES
+#define FLASH_MODEL_WRITE_CYCLES 500
+#endif
+
+// Page and full erase, core clocks (assumed 4 ms and 20 ms at 50 MHz).
+#ifndef FLASH_MODEL_ERASE_PAGE_CYCLES
+#define FLASH_MODEL_ERASE_PAGE_CYCLES 200000
+#endif
+
+#ifndef FLASH_MODEL_ERASE_FULL_CYCLES
+#define FLASH_MODEL_ERASE_FULL_CYCLES 1000000
+#endif
+
+typedef enum {
+    FLASH_Cmd_Read = FLASH_CMD_RD_Msk,
+    FLASH_Cmd_Write = FLASH_CMD_WR_Msk,
+    FLASH_Cmd_EraseFull = FLASH_CMD_ERSEC_Msk | FLASH_CMD_ALLSEC_Msk,
+    FLASH_Cmd_ErasePage = FLASH_CMD_ERSEC_Msk,
+} FLASH_Cmd_TypeDef;
+
+typedef enum {
+    FLASH_Region_Main = 0UL,
+    FLASH_Region_NVR = FLASH_CMD_NVRON_Msk,
+} FLASH_Region_TypeDef;
+
+/** Model state. The arrays hold the flash contents, the counters record how
+ * the loader drove the controller.
+ */
+typedef struct {
+    uint8_t main[MEM_FLASH_SIZE];
+    uint8_t nvr[MEM_FLASH_NVR_SIZE];
+
+    uint32_t addr;
+    uint32_t data[4];
+    uint32_t latched[4];    // DATA sampled by the last write command
+
+    uint64_t now;           // Core clocks
+    uint64_t busy_until;
+    uint32_t pending_cmd;   // Command in progress, 0 if idle
+    uint32_t pending_addr;
+
+    // When set, a write takes DATA at the end of BUSY instead of at the
+    // command. The manual does not say which one the hardware does.
+    int late_latch;
+
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t page_erases;
+    uint32_t full_erases;
+    uint32_t cache_flushes;
+    uint32_t data_writes_busy;  // DATA loaded while a write was in progress
+
+    // Protocol errors, must stay zero.
+    uint32_t cmd_while_busy;
+    uint32_t data_read_while_busy;
+    uint32_t bad_addr;
+} flash_model_t;
+
+extern flash_model_t flash_model;
+
+/** Erase both regions, clear the counters and the clock.
+ */
+void flash_model_reset(void);
+
+/** Let the clock run until the controller is idle.
+ */
+void flash_model_settle(void);
+
+/** Raw access to the model arrays (controller address space of a region).
+ */
+uint8_t *flash_model_mem(FLASH_Region_TypeDef region, uint32_t addr);
+
+void FLASH_SetAddr(uint32_t AddrVal);
+void FLASH_SetData(uint32_t DataNum, uint32_t DataVal);
+uint32_t FLASH_GetData(uint32_t DataNum);
+void FLASH_SetCmd(FLASH_Cmd_TypeDef Cmd, FLASH_Region_TypeDef Region);
+FlagStatus FLASH_BusyStatus(void);
+void FLASH_EraseFull(FLASH_Region_TypeDef Region);
+
+extern RCU_TypeDef flash_model_rcu;
+extern CRC_TypeDef flash_model_crc0;
+
+#undef RCU
+#define RCU (&flash_model_rcu)
+#undef CRC0
+#define CRC0 (&flash_model_crc0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_MODEL_H
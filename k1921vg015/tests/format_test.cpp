@@ -0,0 +1,240 @@
+/** Host test of the formatter (platform/retarget/format.h).
+ *
+ * The run-time parser behind vsnprintf() (printf.cpp) is compared against the
+ * host C library for the integer and string conversions, the compile-time
+ * path of FMT() strings against the same expected text. Conversions that
+ * format.h does not support must come out literally at run time.
+ *
+ * Built twice: with FMT_RUNTIME_FULL (64-bit and %f at run time) and without
+ * it, where those conversions are copied to the output as well.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "format.h"
+
+static int failures;
+
+#define CHECK(COND)                                                      \
+    do {                                                                 \
+        if (!(COND)) {                                                   \
+            if (failures++ < 20)                                         \
+                fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,   \
+                        __LINE__, #COND);                                \
+        }                                                                \
+    } while (0)
+
+static int run_vformat(char *buf, size_t size, const char *f, va_list ap)
+{
+    fmt::buffer_output out(buf, size);
+    int n = fmt::vformat(out, f, ap);
+
+    out.finish();
+    return n;
+}
+
+/** vsnprintf() of printf.cpp.
+ */
+static int format_buffer(char *buf, size_t size, const char *f, ...)
+{
+    va_list ap;
+
+    va_start(ap, f);
+    int n = run_vformat(buf, size, f, ap);
+    va_end(ap);
+    return n;
+}
+
+/** Format with vformat() and the host vsnprintf(), the results must match.
+ */
+static void check_libc(const char *f, ...)
+{
+    char got[128];
+    char want[128];
+    va_list ap, ap2;
+
+    va_start(ap, f);
+    va_copy(ap2, ap);
+    int n = run_vformat(got, sizeof(got), f, ap);
+    int m = vsnprintf(want, sizeof(want), f, ap2);
+    va_end(ap2);
+    va_end(ap);
+
+    if (n != m || strcmp(got, want) != 0) {
+        if (failures++ < 20) fprintf(stderr, "\"%s\": got \"%s\" (%d), want \"%s\" (%d)\n", f, got, n, want, m);
+    }
+}
+
+/** Format with vformat(), the result must be want.
+ */
+static void check_text(const char *want, const char *f, ...)
+{
+    char got[128];
+    va_list ap;
+
+    va_start(ap, f);
+    int n = run_vformat(got, sizeof(got), f, ap);
+    va_end(ap);
+
+    if (n != (int)strlen(want) || strcmp(got, want) != 0) {
+        if (failures++ < 20) fprintf(stderr, "\"%s\": got \"%s\" (%d), want \"%s\"\n", f, got, n, want);
+    }
+}
+
+/** Integer and string conversions with flags, width and precision.
+ */
+static void test_libc(void)
+{
+    check_libc("%d %i %u", -42, 42, 3000000000u);
+    check_libc("%5d|%-5d|%05d|%+d|% d", 42, 42, -42, 42, 42);
+    check_libc("%x %X %#x %#X %08x %.4x", 0xbeefu, 0xbeefu, 0xbeefu, 0u, 0x1fu, 0xau);
+    check_libc("%o %#o %5o %-6o| %#.5o %.0o %#.0o %#o", 8u, 8u, 64u, 7u, 8u, 0u, 0u, 0u);
+    check_libc("%o %#o", UINT32_MAX, 01234567u);
+    check_libc("%c%c %5c|%-3c|", 'o', 'k', 'x', 'y');
+    check_libc("%s %.3s %8s|%-8s|", "text", "abcdef", "r", "l");
+    check_libc("%hd %hhu", 1234, 200);
+    check_libc("100%% %d%%", 5);
+}
+
+#ifdef FMT_RUNTIME_FULL
+/** %j is intmax_t, which is 64-bit on the target as well.
+ */
+static void test_intmax(void)
+{
+    // long, size_t and ptrdiff_t are 64-bit on the host
+    check_libc("%ld %lu %zu %td", -7L, 7UL, (size_t)123456, (ptrdiff_t)-5);
+    check_libc("%lld %llu %llx", (long long)INT64_MIN, (unsigned long long)UINT64_MAX, 0x123456789abcdefull);
+    check_libc("%llo %#llo", (unsigned long long)UINT64_MAX, 1ull << 63);
+    check_libc("%jd %ju", (intmax_t)INT64_MIN, (uintmax_t)UINT64_MAX);
+    check_libc("%jx %jo %jd", (uintmax_t)0x1122334455667788ull, (uintmax_t)1 << 40, (intmax_t)-1);
+    check_libc("%jd|%s", (intmax_t)1 << 33, "next");
+
+    // The argument after a 64-bit one is read from the right place
+    check_text("8589934592 7", "%jd %d", (intmax_t)1 << 33, 7);
+    check_text("18446744073709551615 x", "%ju %s", (uintmax_t)UINT64_MAX, "x");
+}
+
+/** %f at run time is computed in float, see format.h.
+ */
+static void test_float(void)
+{
+    check_libc("%f %.2f %.0f %8.3f|%-8.1f|%+.1f", 1.5, 3.14159, 2.5, -0.125, 7.25, 0.75);
+    check_libc("%f %.3f %05.1f %#.0f", 0.0, -1e-4, 9.96, 3.0);
+    check_libc("%f %f", 1.0 / 0.0, -1.0 / 0.0);
+
+    // A double is rounded to float: 24 significant bits
+    check_text("123456792.000000", "%f", 123456789.0);
+    check_text("16777216.000000 16777220.000000", "%f %f", 16777217.0, 16777219.0);
+
+    // Digits asked beyond the 9th are zeros, the field keeps its length
+    check_text("0.500000000000", "%.12f", 0.5);
+    check_text("  0.250000000000|", "%16.12f|", 0.25);
+    check_text("1.250000000000 7", "%.12f %d", 1.25, 7);
+}
+#else
+/** The small run-time path copies 64-bit and %f conversions to the output
+ * and skips their argument.
+ */
+static void test_small(void)
+{
+    check_text("%lld 7", "%lld %d", (long long)INT64_MIN, 7);
+    check_text("%jx|x", "%jx|%s", (uintmax_t)1 << 40, "x");
+    check_text("%8.3f 5 %f", "%8.3f %d %f", 1.5, 5, 2.0);
+}
+#endif
+
+/** snprintf() semantics of the buffer sink: the output is cut to size - 1
+ * characters and terminated, the full length is returned.
+ */
+static void test_truncate(void)
+{
+    char buf[8];
+    int n;
+
+    memset(buf, 'x', sizeof(buf));
+    n = fmt::format_to(buf, 5, FMT("%s-%d"), "abcdef", 42);
+    CHECK(n == 9 && strcmp(buf, "abcd") == 0 && buf[5] == 'x');
+
+    memset(buf, 'x', sizeof(buf));
+    n = fmt::format_to(buf, 0, FMT("%08x"), 1u);
+    CHECK(n == 8 && buf[0] == 'x');
+
+    n = fmt::format_to(buf, FMT("%d"), 1234567);
+    CHECK(n == 7 && strcmp(buf, "1234567") == 0);
+
+    n = fmt::format_to(buf, FMT("%d"), 12345678);
+    CHECK(n == 8 && strcmp(buf, "1234567") == 0);
+
+    CHECK(format_buffer(nullptr, 0, "%u|%s", 1u, "ab") == 4);
+
+    n = format_buffer(buf, 3, "%u|%s", 1u, "ab");
+    CHECK(n == 4 && strcmp(buf, "1|") == 0);
+}
+
+/** Unsupported conversions are copied to the output and take no argument.
+ */
+static void test_unsupported(void)
+{
+    check_text("a%eb 5", "a%eb %d", 5);
+    check_text("%10.3g|7", "%10.3g|%d", 7);
+    check_text("%n%q", "%n%q");
+    check_text("100%", "100%");
+    check_text("x%", "x%");
+    check_text("%9999d 1", "%9999d %d", 1);
+}
+
+/** Compile-time format strings: the argument type decides, a wider length
+ * modifier widens the value as the C cast to intmax_t/uintmax_t would.
+ */
+static void test_compiled(void)
+{
+    char buf[64];
+    int n;
+
+    n = fmt::format_to(buf, FMT("%jd %ju"), (int64_t)INT64_MIN, (uint64_t)UINT64_MAX);
+    CHECK(strcmp(buf, "-9223372036854775808 18446744073709551615") == 0 && n == 41);
+
+    fmt::format_to(buf, FMT("%jd %jx %ju"), -1, -1, 5u);
+    CHECK(strcmp(buf, "-1 ffffffffffffffff 5") == 0);
+
+    fmt::format_to(buf, FMT("%x %llx"), -1, -1);
+    CHECK(strcmp(buf, "ffffffff ffffffffffffffff") == 0);
+
+    fmt::format_to(buf, FMT("%o %#o %#llo"), 8u, 8, (uint64_t)1 << 63);
+    CHECK(strcmp(buf, "10 010 01000000000000000000000") == 0);
+
+    fmt::format_to(buf, FMT("%d %s %.2f"), 3, "v", 1.25f);
+    CHECK(strcmp(buf, "3 v 1.25") == 0);
+
+    fmt::format_to(buf, FMT("%.11f|%12.10f"), 0.5, fmt::q<8>(-384));
+    CHECK(strcmp(buf, "0.50000000000|-1.5000000000") == 0);
+
+    // FMT() strings with unsupported conversions do not compile
+    static_assert(fmt::detail::count_specs("%e") == 0, "%e must be rejected");
+    static_assert(fmt::detail::count_specs("%o") == 2, "%o must be accepted");
+    static_assert(!fmt::detail::check_args<float>("%o"), "%o takes integers only");
+}
+
+int main(void)
+{
+    test_libc();
+#ifdef FMT_RUNTIME_FULL
+    test_intmax();
+    test_float();
+#else
+    test_small();
+#endif
+    test_truncate();
+    test_unsupported();
+    test_compiled();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef RISCV_HOST_H
+#define RISCV_HOST_H
+
+/** Host stand-in for riscv-csr.h, force-included (-include) into device
+ * sources built for the host tests. It defines the include guard of
+ * riscv-csr.h so the real header (inline csrr/csrw) is skipped, and emulates
+ * the few CSRs the sources touch. mcycle counts host nanoseconds.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#define RISCV_CSR_H
+
+typedef uint32_t uint_xlen_t;
+
+#define MSTATUS_MIE_BIT_MASK 0x8
+
+extern uint_xlen_t host_mstatus;
+extern uint_xlen_t host_mie;
+
+static inline void csr_write_mstatus(uint_xlen_t value) {
+    host_mstatus = value;
+}
+
+static inline uint_xlen_t csr_read_mstatus(void) {
+    return host_mstatus;
+}
+
+static inline uint_xlen_t csr_read_clr_bits_mstatus(uint_xlen_t mask) {
+    uint_xlen_t value = host_mstatus;
+    host_mstatus &= ~mask;
+    return value;
+}
+
+static inline void csr_set_bits_mie(uint_xlen_t mask) {
+    host_mie |= mask;
+}
+
+static inline void csr_clr_bits_mie(uint_xlen_t mask) {
+    host_mie &= ~mask;
+}
+
+static inline uint64_t csr_read_mcycle(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif // RISCV_HOST_H
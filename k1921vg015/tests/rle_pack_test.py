@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Host test of segger-flash-loader/tools/rle_pack.py.
+
+Packs a synthetic image with erased, constant and random sectors, then replays
+the generated J-Link Commander script: every ProgramCompressed() call must
+point at a stream in the loaded batch files that unpacks to its sector.
+The loader ELF is a minimal ELF32 carrying only the symbol table.
+"""
+
+import os
+import random
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "segger-flash-loader", "tools")
+sys.path.insert(0, TOOLS)
+
+import rle_pack  # noqa: E402
+
+SYMBOLS = {
+    "Init": 0x400000B8,
+    "UnInit": 0x40000018,
+    "EraseSector": 0x4000001C,
+    "ProgramCompressed": 0x40000400,
+}
+
+
+def make_loader_elf(path):
+    """ELF32 LE with a .symtab, .strtab and .shstrtab only."""
+    strtab = b"\0"
+    symtab = bytes(16)
+    for name, value in SYMBOLS.items():
+        symtab += struct.pack("<IIIBBH", len(strtab), value, 0, 0x12, 0, 1)
+        strtab += name.encode() + b"\0"
+    shstrtab = b"\0.symtab\0.strtab\0.shstrtab\0"
+
+    body = symtab + strtab + shstrtab
+    sym_off = 52
+    str_off = sym_off + len(symtab)
+    shs_off = str_off + len(strtab)
+    sh_off = (52 + len(body) + 3) & ~3
+
+    header = b"\x7fELF" + bytes([1, 1, 1]) + bytes(9)
+    header += struct.pack("<HHIIIIIHHHHHH", 2, 0xF3, 1, 0, 0, sh_off, 0, 52, 0, 0, 40, 4, 3)
+
+    sections = bytes(40)
+    sections += struct.pack("<IIIIIIIIII", 1, 2, 0, 0, sym_off, len(symtab), 2, 1, 4, 16)
+    sections += struct.pack("<IIIIIIIIII", 9, 3, 0, 0, str_off, len(strtab), 0, 0, 1, 0)
+    sections += struct.pack("<IIIIIIIIII", 17, 3, 0, 0, shs_off, len(shstrtab), 0, 0, 1, 0)
+
+    data = header + body
+    data += bytes(sh_off - len(data)) + sections
+
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def make_image():
+    rnd = random.Random(1)
+    image = bytearray()
+
+    for kind in ["code", "erased", "fill", "code", "sparse", "erased", "code"] * 24:
+        if kind == "code":
+            sector = bytes(rnd.randrange(256) for _ in range(rle_pack.SECTOR_SIZE))
+        elif kind == "erased":
+            sector = bytes([0xFF]) * rle_pack.SECTOR_SIZE
+        elif kind == "fill":
+            sector = bytes([0x00]) * rle_pack.SECTOR_SIZE
+        else:
+            sector = bytearray([0xFF]) * rle_pack.SECTOR_SIZE
+            sector[100:300] = bytes(rnd.randrange(256) for _ in range(200))
+        image += sector
+
+    return bytes(image)
+
+
+def main():
+    failures = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        loader = os.path.join(tmp, "loader.elf")
+        image_path = os.path.join(tmp, "image.bin")
+        script = os.path.join(tmp, "image.jlink")
+
+        make_loader_elf(loader)
+        image = make_image()
+
+        with open(image_path, "wb") as f:
+            f.write(image)
+
+        subprocess.run([sys.executable, os.path.join(TOOLS, "rle_pack.py"), image_path, "--bin",
+                        "--jlink", script, "--loader", loader, "--stats"], check=True)
+
+        assert rle_pack.load_elf_symbols(loader) == {"": 0, **SYMBOLS}
+
+        buffer = b""
+        regs = {}
+        programmed = {}
+        erased = set()
+
+        for line in open(script):
+            line = line.strip()
+
+            m = re.match(r"loadbin (\S+), 0x([0-9A-F]+)$", line)
+            if m:
+                assert int(m.group(2), 16) == rle_pack.JLINK_BUFFER_ADDR
+                buffer = open(m.group(1), "rb").read()
+                assert len(buffer) <= rle_pack.JLINK_BUFFER_SIZE
+                continue
+
+            m = re.match(r"wreg x(\d+), 0x([0-9A-F]+)$", line)
+            if m:
+                regs[int(m.group(1))] = int(m.group(2), 16)
+                continue
+
+            m = re.match(r"setpc 0x([0-9A-F]+)$", line)
+            if m:
+                func = int(m.group(1), 16)
+                assert regs[1] == rle_pack.JLINK_RETURN_ADDR
+
+                if func == SYMBOLS["EraseSector"]:
+                    erased.add(regs[10])
+                elif func == SYMBOLS["ProgramCompressed"]:
+                    addr, size, ptr = regs[10], regs[11], regs[12]
+                    assert addr in erased, "sector 0x%08X programmed before erase" % addr
+                    assert ptr % 4 == 0
+                    offset = ptr - rle_pack.JLINK_BUFFER_ADDR
+                    programmed[addr] = rle_pack.decompress(buffer[offset:offset + size])
+
+        for offset in range(0, len(image), rle_pack.SECTOR_SIZE):
+            sector = image[offset:offset + rle_pack.SECTOR_SIZE]
+            addr = rle_pack.FLASH_BASE + offset
+
+            if sector.count(0xFF) == len(sector):
+                if addr in programmed:
+                    print("erased sector 0x%08X was sent" % addr)
+                    failures += 1
+            elif programmed.get(addr) != sector:
+                print("sector 0x%08X does not match" % addr)
+                failures += 1
+
+    if failures:
+        sys.exit("%d failure(s)" % failures)
+
+
+if __name__ == "__main__":
+    main()
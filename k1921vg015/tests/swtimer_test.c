@@ -0,0 +1,386 @@
+/** Host test and benchmark of the software timer wheel (swtimer.c).
+ *
+ * mtime is simulated: run_until() advances it and takes the machine timer
+ * interrupt whenever it reaches the mtimecmp value programmed by the wheel,
+ * optionally a random number of clocks late. Every callback checks its timer
+ * against a reference expiry, so the test proves that no timer fires early,
+ * late (beyond the interrupt delay), twice, out of order or after a stop.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "swtimer.h"
+#include "riscv-irq.h"
+
+uint_xlen_t host_mstatus = MSTATUS_MIE_BIT_MASK;
+uint_xlen_t host_mie;
+
+static uint64_t mtime;
+static uint64_t mtimecmp = UINT64_MAX;
+static irqfunc_t *mti_handler;
+static uint64_t irq_delay;      // Maximum interrupt delay, clocks
+static uint32_t interrupts;
+
+uint64_t mtimer_get_raw_time(void)
+{
+    return mtime;
+}
+
+void mtimer_set_raw_time_cmp_abs(uint64_t new_mtimecmp)
+{
+    mtimecmp = new_mtimecmp;
+}
+
+void riscv_irq_set_handler(unsigned int irq, irqfunc_t *handler)
+{
+    if (irq == RISCV_IRQ_MTI) mti_handler = handler;
+}
+
+static int failures;
+
+#define CHECK(COND)                                                      \
+    do {                                                                 \
+        if (!(COND)) {                                                   \
+            if (failures++ < 20)                                         \
+                fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,   \
+                        __LINE__, #COND);                                \
+        }                                                                \
+    } while (0)
+
+static uint64_t rand64(void)
+{
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+/** Advance mtime to until, taking the timer interrupt on the way.
+ */
+static void run_until(uint64_t until)
+{
+    while (mtimecmp <= until) {
+        uint64_t at = mtimecmp + (irq_delay ? rand64() % (irq_delay + 1) : 0);
+
+        if (at > mtime) mtime = at;
+
+        uint64_t before = mtimecmp;
+
+        interrupts++;
+        mti_handler();
+
+        // The handler must move the compare point past the current time.
+        CHECK(mtimecmp > mtime || mtimecmp == UINT64_MAX);
+        if (mtimecmp <= before && mtimecmp <= mtime) return;
+    }
+
+    if (until > mtime) mtime = until;
+}
+
+static void run_ticks(uint64_t ticks)
+{
+    run_until(mtime + (ticks << SWTIMER_TICK_SHIFT));
+}
+
+/** Timer under test with its reference state.
+ */
+typedef struct {
+    swtimer_t timer;
+    uint64_t expect;        // Next expected expiry, ticks
+    uint32_t fired;
+    uint32_t restarts;      // Restart from the callback this many times
+    int stopped;
+} probe_t;
+
+static uint64_t last_fire;  // Expiry of the previous callback
+static uint64_t max_late;   // Largest lateness seen, ticks
+
+static void probe_cb(swtimer_t *timer, void *arg)
+{
+    probe_t *p = arg;
+    uint64_t now = swtimer_now();
+
+    CHECK(&p->timer == timer);
+    CHECK(!p->stopped);
+    CHECK(now >= p->expect);
+    CHECK(p->expect >= last_fire);
+
+    if (now - p->expect > max_late) max_late = now - p->expect;
+    last_fire = p->expect;
+    p->fired++;
+
+    if (p->timer.period) {
+        p->expect += p->timer.period;
+    } else if (p->restarts) {
+        uint32_t delay = (uint32_t)(rand() % 5000);
+
+        p->restarts--;
+        p->expect = swtimer_now() + delay;
+        swtimer_start(&p->timer, delay, 0);
+    }
+}
+
+static void probe_start(probe_t *p, uint32_t delay, uint32_t period)
+{
+    memset(p, 0, sizeof(*p));
+    swtimer_setup(&p->timer, probe_cb, p);
+    p->expect = swtimer_now() + delay;
+    swtimer_start(&p->timer, delay, period);
+}
+
+static void reset(uint64_t delay)
+{
+    mtime = rand64() & ((1ULL << 40) - 1);
+    mtimecmp = UINT64_MAX;
+    irq_delay = delay;
+    last_fire = 0;
+    max_late = 0;
+    interrupts = 0;
+    swtimer_init();
+    swtimer_stats_reset();
+}
+
+#define N_TIMERS 5000
+
+static probe_t probes[N_TIMERS];
+
+/** One-shot timers over all wheel levels and the overflow list fire exactly
+ * once, at their tick.
+ */
+static void test_oneshot(uint64_t delay)
+{
+    reset(delay);
+
+    for (int i = 0; i < N_TIMERS; i++) {
+        uint32_t d;
+
+        switch (i % 4) {
+        case 0: d = (uint32_t)(rand() % 64); break;
+        case 1: d = (uint32_t)(rand() % (1 << 16)); break;
+        case 2: d = (uint32_t)(rand64() % (1u << 30)); break;
+        default: d = (uint32_t)(rand64() % UINT32_MAX); break;  // Beyond the wheel
+        }
+
+        probe_start(&probes[i], d, 0);
+    }
+
+    CHECK(swtimer_stats.active == N_TIMERS);
+
+    run_ticks(1ULL << 33);
+
+    for (int i = 0; i < N_TIMERS; i++) {
+        CHECK(probes[i].fired == 1);
+    }
+
+    CHECK(swtimer_stats.active == 0);
+    CHECK(swtimer_stats.expired == N_TIMERS);
+    CHECK(mtimecmp == UINT64_MAX);
+    CHECK(max_late <= ((delay >> SWTIMER_TICK_SHIFT) + 1));
+    if (delay == 0) CHECK(max_late == 0);
+}
+
+/** Stopped timers never fire, also when stopped from another callback.
+ */
+static probe_t *victim;
+
+static void stopper_cb(swtimer_t *timer, void *arg)
+{
+    (void)timer;
+    (void)arg;
+    swtimer_stop(&victim->timer);
+    victim->stopped = 1;
+}
+
+static void test_stop(void)
+{
+    reset(0);
+
+    for (int i = 0; i < N_TIMERS; i++) {
+        probe_start(&probes[i], 10 + (uint32_t)(rand() % 100000), 0);
+    }
+
+    for (int i = 0; i < N_TIMERS; i += 2) {
+        swtimer_stop(&probes[i].timer);
+        probes[i].stopped = 1;
+        CHECK(!swtimer_is_active(&probes[i].timer));
+    }
+
+    // Stopping an inactive timer does nothing.
+    swtimer_stop(&probes[0].timer);
+
+    swtimer_t stopper;
+    victim = &probes[1];
+    swtimer_setup(&stopper, stopper_cb, 0);
+    swtimer_start(&stopper, (uint32_t)(probes[1].expect - swtimer_now()) - 1, 0);
+
+    run_ticks(200000);
+
+    for (int i = 0; i < N_TIMERS; i++) {
+        CHECK(probes[i].fired == (probes[i].stopped ? 0u : 1u));
+    }
+
+    CHECK(swtimer_stats.active == 0);
+}
+
+/** Periodic timers fire at expires + k * period, including catch-up after a
+ * late interrupt.
+ */
+static void test_periodic(uint64_t delay)
+{
+    enum { N = 200, TICKS = 300000 };
+
+    reset(delay);
+
+    uint64_t start = swtimer_now();
+
+    for (int i = 0; i < N; i++) {
+        uint32_t period = 1 + (uint32_t)(rand() % 7000);
+        probe_start(&probes[i], period, period);
+    }
+
+    run_until(((start + TICKS) << SWTIMER_TICK_SHIFT) + (1u << SWTIMER_TICK_SHIFT) - 1);
+
+    for (int i = 0; i < N; i++) {
+        uint32_t expect = TICKS / probes[i].timer.period;
+
+        // A late interrupt near the end may already run the next period.
+        CHECK(probes[i].fired == expect || (delay && probes[i].fired == expect + 1));
+        swtimer_stop(&probes[i].timer);
+    }
+
+    CHECK(max_late <= ((delay >> SWTIMER_TICK_SHIFT) + 1));
+
+    CHECK(swtimer_stats.active == 0);
+}
+
+/** Callbacks restart their own timer.
+ */
+static void test_restart(void)
+{
+    enum { N = 500, RESTARTS = 20 };
+
+    reset(0);
+
+    for (int i = 0; i < N; i++) {
+        probe_start(&probes[i], (uint32_t)(rand() % 5000), 0);
+        probes[i].restarts = RESTARTS;
+    }
+
+    run_ticks(1ULL << 20);
+
+    for (int i = 0; i < N; i++) {
+        CHECK(probes[i].fired == RESTARTS + 1);
+    }
+
+    CHECK(swtimer_stats.active == 0);
+    CHECK(max_late == 0);
+}
+
+/** A wheel that was idle for a long time starts timers in the low levels.
+ */
+static void test_idle(void)
+{
+    reset(0);
+
+    probe_start(&probes[0], 10, 0);
+    run_ticks(20);
+    CHECK(probes[0].fired == 1);
+
+    // Long idle period without any timer (mtimecmp is not programmed).
+    mtime += 1ULL << 45;
+
+    probe_start(&probes[1], 3, 0);
+    CHECK(mtimecmp == (probes[1].expect << SWTIMER_TICK_SHIFT));
+    run_ticks(3);
+    CHECK(probes[1].fired == 1);
+    CHECK(max_late == 0);
+}
+
+/** A timer started at a tick already passed fires at the next dispatch, not
+ * one tick later.
+ */
+static void test_overdue(void)
+{
+    reset(0);
+
+    memset(&probes[0], 0, sizeof(probes[0]));
+    swtimer_setup(&probes[0].timer, probe_cb, &probes[0]);
+    probes[0].expect = swtimer_now() - 5;
+    swtimer_start_at(&probes[0].timer, probes[0].expect, 0);
+
+    CHECK(mtimecmp <= mtime);
+    run_until(mtime);
+    CHECK(probes[0].fired == 1);
+    CHECK(swtimer_stats.active == 0);
+}
+
+static uint64_t host_ns(void)
+{
+    return csr_read_mcycle();
+}
+
+static void nop_cb(swtimer_t *timer, void *arg)
+{
+    (void)timer;
+    (void)arg;
+}
+
+/** Insert, cancel and expiry cost for n timers, in host nanoseconds.
+ */
+static void bench(int n)
+{
+    swtimer_t *timers = malloc(sizeof(swtimer_t) * (size_t)n);
+    uint32_t *delays = malloc(sizeof(uint32_t) * (size_t)n);
+
+    reset(0);
+
+    for (int i = 0; i < n; i++) {
+        swtimer_setup(&timers[i], nop_cb, 0);
+        delays[i] = 1 + (uint32_t)(rand() % 1000000);
+    }
+
+    uint64_t t0 = host_ns();
+    for (int i = 0; i < n; i++) swtimer_start(&timers[i], delays[i], 0);
+    uint64_t t1 = host_ns();
+    for (int i = 0; i < n; i++) swtimer_stop(&timers[i]);
+    uint64_t t2 = host_ns();
+    for (int i = 0; i < n; i++) swtimer_start(&timers[i], delays[i], 0);
+
+    swtimer_stats_reset();
+    uint64_t t3 = host_ns();
+    run_ticks(1000001);
+    uint64_t t4 = host_ns();
+
+    CHECK(swtimer_stats.expired == (uint32_t)n);
+
+    printf("  %7d timers: start %6.1f ns, stop %6.1f ns, expiry %6.1f ns (%u interrupts, %u cascades)\n", n,
+           (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t4 - t3) / n, (unsigned)interrupts,
+           (unsigned)swtimer_stats.cascaded);
+
+    free(timers);
+    free(delays);
+}
+
+int main(void)
+{
+    srand(1);
+
+    test_oneshot(0);
+    test_oneshot(3000);
+    test_stop();
+    test_periodic(0);
+    test_periodic(5000);
+    test_restart();
+    test_idle();
+    test_overdue();
+
+    printf("swtimer wheel, host nanoseconds per operation (delays up to 10^6 ticks):\n");
+    bench(1000);
+    bench(10000);
+    bench(100000);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}